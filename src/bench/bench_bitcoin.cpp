@@ -6,6 +6,7 @@
 
 #include <clientversion.h>
 #include <crypto/sha256.h>
+#include <crypto/siphash.h>
 #include <fs.h>
 #include <util/strencodings.h>
 #include <util/system.h>
@@ -50,6 +51,7 @@ int main(int argc, char** argv)
     ArgsManager argsman;
     SetupBenchArgs(argsman);
     SHA256AutoDetect();
+    SipHashAutoDetect();
     std::string error;
     if (!argsman.ParseParameters(argc, argv, error)) {
         tfm::format(std::cerr, "Error parsing command line arguments: %s\n", error);
@@ -0,0 +1,89 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <sync.h>
+#include <validation.h>
+
+#include <cassert>
+#include <vector>
+
+using node::BlockManager;
+
+static constexpr int NUM_HEADERS{100000};
+
+//! A chain of headers, each building on the previous one.
+static std::vector<CBlockHeader> CreateHeaders(int count)
+{
+    std::vector<CBlockHeader> headers(count);
+    for (int i = 0; i < count; ++i) {
+        CBlockHeader& header{headers[i]};
+        header.nVersion = 4;
+        header.hashPrevBlock = i > 0 ? headers[i - 1].GetHash() : uint256{};
+        header.nTime = 1231006505 + i * 600;
+        header.nBits = 0x207fffff;
+        header.nNonce = i;
+    }
+    return headers;
+}
+
+// Header sync: add a long chain of headers to an empty block index.
+static void BlockIndexAddHeaders(benchmark::Bench& bench)
+{
+    const std::vector<CBlockHeader> headers{CreateHeaders(NUM_HEADERS)};
+    bench.batch(headers.size()).unit("header").run([&] {
+        BlockManager blockman;
+        CBlockIndex* best_header{nullptr};
+        LOCK(::cs_main);
+        for (const CBlockHeader& header : headers) {
+            blockman.AddToBlockIndex(header, best_header);
+        }
+        assert(best_header->nHeight == NUM_HEADERS - 1);
+    });
+}
+
+static void BlockIndexLookup(benchmark::Bench& bench)
+{
+    const std::vector<CBlockHeader> headers{CreateHeaders(NUM_HEADERS)};
+    std::vector<uint256> hashes;
+    for (const CBlockHeader& header : headers) hashes.push_back(header.GetHash());
+    BlockManager blockman;
+    CBlockIndex* best_header{nullptr};
+    LOCK(::cs_main);
+    for (const CBlockHeader& header : headers) {
+        blockman.AddToBlockIndex(header, best_header);
+    }
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    bench.run([&] {
+        const CBlockIndex* pindex{blockman.LookupBlockIndex(hashes[rng.randrange(hashes.size())])};
+        ankerl::nanobench::doNotOptimizeAway(pindex);
+    });
+}
+
+// Skiplist walks from the tip, as done by locators, FindFork and LastCommonAncestor.
+static void BlockIndexGetAncestor(benchmark::Bench& bench)
+{
+    const std::vector<CBlockHeader> headers{CreateHeaders(NUM_HEADERS)};
+    BlockManager blockman;
+    CBlockIndex* best_header{nullptr};
+    LOCK(::cs_main);
+    for (const CBlockHeader& header : headers) {
+        blockman.AddToBlockIndex(header, best_header);
+    }
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    bench.run([&] {
+        const CBlockIndex* pindex{best_header->GetAncestor(rng.randrange(NUM_HEADERS))};
+        ankerl::nanobench::doNotOptimizeAway(pindex);
+    });
+}
+
+BENCHMARK(BlockIndexAddHeaders);
+BENCHMARK(BlockIndexLookup);
+BENCHMARK(BlockIndexGetAncestor);
@@ -0,0 +1,82 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockencodings.h>
+#include <chainparamsbase.h>
+#include <consensus/amount.h>
+#include <random.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <validation.h>
+
+static constexpr size_t MEMPOOL_TX_COUNT{300000};
+static constexpr size_t BLOCK_TX_COUNT{3000};
+
+static void AddTx(const CTransactionRef& tx, const CAmount& fee, CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
+{
+    LockPoints lp;
+    pool.addUnchecked(CTxMemPoolEntry(tx, fee, /*time=*/0, /*entry_height=*/1, /*spends_coinbase=*/false, /*sigops_cost=*/4, lp));
+}
+
+static CTransactionRef MakeTx(uint32_t n)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout.n = n;
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vin[0].scriptWitness.stack.push_back({1});
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+    tx.vout[0].nValue = COIN;
+    return MakeTransactionRef(tx);
+}
+
+/** Reconstruct a compact block of transactions from the top of a large
+ * mempool, of which missing_count are not in the mempool. */
+static void RunCompactBlockReconstruction(benchmark::Bench& bench, size_t missing_count)
+{
+    const auto testing_setup = MakeNoLogFileContext<const ChainTestingSetup>(CBaseChainParams::MAIN);
+    CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
+    FastRandomContext det_rand{true};
+
+    CBlock block;
+    block.nBits = 0x207fffff;
+    block.vtx.push_back(MakeTx(MEMPOOL_TX_COUNT + BLOCK_TX_COUNT));
+    {
+        LOCK2(cs_main, pool.cs);
+        for (uint32_t i = 0; i < MEMPOOL_TX_COUNT; ++i) {
+            AddTx(MakeTx(i), /*fee=*/det_rand.randrange(100000), pool);
+        }
+        // Select the transactions with the highest feerates, as a miner would
+        const auto& by_ancestor_score = pool.mapTx.get<ancestor_score>();
+        for (auto it = by_ancestor_score.begin(); block.vtx.size() < BLOCK_TX_COUNT - missing_count; ++it) {
+            block.vtx.push_back(it->GetSharedTx());
+        }
+    }
+    for (size_t i = 0; i < missing_count; ++i) {
+        block.vtx.push_back(MakeTx(MEMPOOL_TX_COUNT + i));
+    }
+    const CBlockHeaderAndShortTxIDs cmpctblock{block};
+    const std::vector<std::pair<uint256, CTransactionRef>> extra_txn;
+
+    bench.run([&] {
+        PartiallyDownloadedBlock partial_block{&pool};
+        const ReadStatus status{partial_block.InitData(cmpctblock, extra_txn)};
+        assert(status == READ_STATUS_OK);
+    });
+}
+
+static void ReconstructCompactBlock(benchmark::Bench& bench)
+{
+    RunCompactBlockReconstruction(bench, /*missing_count=*/0);
+}
+
+static void ReconstructCompactBlockMissingTx(benchmark::Bench& bench)
+{
+    RunCompactBlockReconstruction(bench, /*missing_count=*/1);
+}
+
+BENCHMARK(ReconstructCompactBlock);
+BENCHMARK(ReconstructCompactBlockMissingTx);
@@ -4,10 +4,12 @@
 
 #include <bench/bench.h>
 #include <checkqueue.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <pubkey.h>
 #include <random.h>
+#include <tinyformat.h>
 #include <util/system.h>
 
 #include <vector>
@@ -16,6 +18,7 @@ static const size_t BATCHES = 101;
 static const size_t BATCH_SIZE = 30;
 static const int PREVECTOR_SIZE = 28;
 static const unsigned int QUEUE_BATCH_SIZE = 128;
+static const int MAX_SCALING_THREADS = 64;
 
 // This Benchmark tests the CheckQueue with a slightly realistic workload,
 // where checks all contain a prevector that is indirect 50% of the time
@@ -71,3 +74,42 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     ECC_Stop();
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+
+// This Benchmark tests how the CheckQueue scales with the number of script
+// verification threads, using checks that each take a few microseconds like
+// signature verifications do. Thread counts above the number of cores are
+// included too, but only show the cost of oversubscription.
+static void CCheckQueueScaling(benchmark::Bench& bench)
+{
+    struct HashJob {
+        unsigned char data[32]{};
+        bool operator()()
+        {
+            for (int i = 0; i < 64; ++i) {
+                CSHA256().Write(data, sizeof(data)).Finalize(data);
+            }
+            return true;
+        }
+        void swap(HashJob& x) noexcept
+        {
+            std::swap(data, x.data);
+        };
+    };
+    const std::vector<std::vector<HashJob>> vBatches(BATCHES, std::vector<HashJob>(BATCH_SIZE));
+
+    bench.minEpochIterations(10).batch(BATCH_SIZE * BATCHES).unit("job");
+    for (int threads = 1; threads <= MAX_SCALING_THREADS; threads *= 2) {
+        CCheckQueue<HashJob> queue{QUEUE_BATCH_SIZE};
+        // The main thread is one of the threads.
+        queue.StartWorkerThreads(threads - 1);
+        bench.run(strprintf("CCheckQueueScaling/%d", threads), [&] {
+            CCheckQueueControl<HashJob> control(&queue);
+            for (auto vChecks : vBatches) {
+                control.Add(vChecks);
+            }
+            control.Wait();
+        });
+        queue.StopWorkerThreads();
+    }
+}
+BENCHMARK(CCheckQueueScaling);
@@ -90,6 +90,33 @@ static void SipHash_32b(benchmark::Bench& bench)
     });
 }
 
+static void SipHash_32b_1024(benchmark::Bench& bench)
+{
+    std::vector<uint256> in(1024);
+    std::vector<uint64_t> out(in.size());
+    for (size_t i = 0; i < in.size(); ++i) *((uint64_t*)in[i].begin()) = i;
+    uint64_t k1 = 0;
+    bench.batch(in.size()).unit("hash").run([&] {
+        ++k1;
+        for (size_t i = 0; i < in.size(); ++i) out[i] = SipHashUint256(0, k1, in[i]);
+    });
+}
+
+static void SipHashBatch_32b_1024(benchmark::Bench& bench)
+{
+    std::vector<uint256> in(1024);
+    std::vector<const uint256*> ptrs(in.size());
+    std::vector<uint64_t> out(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        *((uint64_t*)in[i].begin()) = i;
+        ptrs[i] = &in[i];
+    }
+    uint64_t k1 = 0;
+    bench.batch(in.size()).unit("hash").run([&] {
+        SipHashUint256Batch(0, ++k1, ptrs.data(), out.data(), ptrs.size());
+    });
+}
+
 static void FastRandom_32bit(benchmark::Bench& bench)
 {
     FastRandomContext rng(true);
@@ -158,6 +185,8 @@ BENCHMARK(SHA3_256_1M);
 
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
+BENCHMARK(SipHash_32b_1024);
+BENCHMARK(SipHashBatch_32b_1024);
 BENCHMARK(SHA256D64_1024);
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
@@ -23,9 +23,9 @@ static void AddTx(const CTransactionRef& tx, const CAmount& nFee, CTxMemPool& po
 // Right now this is only testing eviction performance in an extremely small
 // mempool. Code needs to be written to generate a much wider variety of
 // unique transactions for a more meaningful performance measurement.
-static void MempoolEviction(benchmark::Bench& bench)
+static void RunMempoolEviction(benchmark::Bench& bench, const std::vector<const char*>& extra_args)
 {
-    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::REGTEST, extra_args);
 
     CMutableTransaction tx1 = CMutableTransaction();
     tx1.vin.resize(1);
@@ -132,4 +132,63 @@ static void MempoolEviction(benchmark::Bench& bench)
     });
 }
 
+static void MempoolEviction(benchmark::Bench& bench)
+{
+    RunMempoolEviction(bench, {});
+}
+
+static void MempoolEvictionClusters(benchmark::Bench& bench)
+{
+    RunMempoolEviction(bench, {"-mempoolclusters=1"});
+}
+
+// Long chains of transactions, where every child pays for its parent, are the
+// worst case for the ancestor and descendant state of mempool entries.
+static void RunMempoolEvictionChains(benchmark::Bench& bench, const std::vector<const char*>& extra_args)
+{
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::REGTEST, extra_args);
+    constexpr int CHAINS{20};
+    constexpr int CHAIN_LENGTH{50};
+
+    std::vector<std::pair<CTransactionRef, CAmount>> txs;
+    for (int chain = 0; chain < CHAINS; ++chain) {
+        for (int i = 0; i < CHAIN_LENGTH; ++i) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            if (i == 0) {
+                tx.vin[0].scriptSig = CScript() << chain;
+            } else {
+                tx.vin[0].prevout = COutPoint(txs.back().first->GetHash(), 0);
+            }
+            tx.vout.resize(1);
+            tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+            tx.vout[0].nValue = 10 * COIN;
+            txs.emplace_back(MakeTransactionRef(tx), i % 2 ? 1000 * (chain + 1) : 100);
+        }
+    }
+
+    CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (const auto& [tx, fee] : txs) {
+            AddTx(tx, fee, pool);
+        }
+        pool.TrimToSize(pool.DynamicMemoryUsage() * 3 / 4);
+        pool.TrimToSize(GetVirtualTransactionSize(*txs.front().first));
+    });
+}
+
+static void MempoolEvictionChains(benchmark::Bench& bench)
+{
+    RunMempoolEvictionChains(bench, {});
+}
+
+static void MempoolEvictionChainsClusters(benchmark::Bench& bench)
+{
+    RunMempoolEvictionChains(bench, {"-mempoolclusters=1"});
+}
+
 BENCHMARK(MempoolEviction);
+BENCHMARK(MempoolEvictionClusters);
+BENCHMARK(MempoolEvictionChains);
+BENCHMARK(MempoolEvictionChainsClusters);
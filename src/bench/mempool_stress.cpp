@@ -79,7 +79,7 @@ static std::vector<CTransactionRef> CreateOrderedCoins(FastRandomContext& det_ra
     return ordered_coins;
 }
 
-static void ComplexMemPool(benchmark::Bench& bench)
+static void RunComplexMemPool(benchmark::Bench& bench, const std::vector<const char*>& extra_args)
 {
     FastRandomContext det_rand{true};
     int childTxs = 800;
@@ -87,7 +87,7 @@ static void ComplexMemPool(benchmark::Bench& bench)
         childTxs = static_cast<int>(bench.complexityN());
     }
     std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, childTxs, /*min_ancestors=*/1);
-    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN, extra_args);
     CTxMemPool& pool = *testing_setup.get()->m_node.mempool;
     LOCK2(cs_main, pool.cs);
     bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
@@ -99,6 +99,16 @@ static void ComplexMemPool(benchmark::Bench& bench)
     });
 }
 
+static void ComplexMemPool(benchmark::Bench& bench)
+{
+    RunComplexMemPool(bench, {});
+}
+
+static void ComplexMemPoolClusters(benchmark::Bench& bench)
+{
+    RunComplexMemPool(bench, {"-mempoolclusters=1"});
+}
+
 static void MempoolCheck(benchmark::Bench& bench)
 {
     FastRandomContext det_rand{true};
@@ -115,4 +125,5 @@ static void MempoolCheck(benchmark::Bench& bench)
 }
 
 BENCHMARK(ComplexMemPool);
+BENCHMARK(ComplexMemPoolClusters);
 BENCHMARK(MempoolCheck);
@@ -0,0 +1,89 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <checkqueue.h>
+#include <key.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <script/interpreter.h>
+#include <script/script.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <vector>
+
+static const size_t INPUTS = 2000;
+static const unsigned int QUEUE_BATCH_SIZE = 128;
+
+//! Wraps CScriptCheck without exposing its Batch type, so every signature is verified on its own.
+struct UnbatchedScriptCheck {
+    CScriptCheck check;
+    UnbatchedScriptCheck() = default;
+    explicit UnbatchedScriptCheck(CScriptCheck&& c) { check.swap(c); }
+    bool operator()() { return check(); }
+    void swap(UnbatchedScriptCheck& x) noexcept { check.swap(x.check); }
+};
+
+// Verify a transaction spending many taproot key path outputs through the
+// check queue, like ConnectBlock does with signatures that are not cached.
+template <typename Check>
+static void SchnorrCheckQueue(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+
+    CKey key;
+    key.MakeNewKey(true);
+    const XOnlyPubKey output_key{XOnlyPubKey(key.GetPubKey()).CreateTapTweak(nullptr)->first};
+    const CTxOut spent_output{1000, GetScriptForDestination(WitnessV1Taproot{output_key})};
+
+    CMutableTransaction mtx;
+    mtx.vin.resize(INPUTS);
+    for (size_t i = 0; i < INPUTS; ++i) mtx.vin[i].prevout = COutPoint(uint256::ONE, i);
+    mtx.vout.emplace_back(INPUTS * 900, spent_output.scriptPubKey);
+    std::vector<CTxOut> spent_outputs(INPUTS, spent_output);
+
+    PrecomputedTransactionData txdata;
+    txdata.Init(mtx, std::vector<CTxOut>{spent_outputs}, /*force=*/true);
+    for (size_t i = 0; i < INPUTS; ++i) {
+        ScriptExecutionData execdata;
+        execdata.m_annex_init = true;
+        execdata.m_annex_present = false;
+        uint256 sighash;
+        assert(SignatureHashSchnorr(sighash, execdata, mtx, i, SIGHASH_DEFAULT, SigVersion::TAPROOT, txdata, MissingDataBehavior::ASSERT_FAIL));
+        std::vector<unsigned char> sig(64);
+        const uint256 merkle_root;
+        assert(key.SignSchnorr(sighash, sig, &merkle_root, GetRandHash()));
+        mtx.vin[i].scriptWitness.stack.push_back(std::move(sig));
+    }
+    const CTransaction tx{mtx};
+    txdata = PrecomputedTransactionData{};
+    txdata.Init(tx, std::move(spent_outputs));
+
+    CCheckQueue<Check> queue{QUEUE_BATCH_SIZE};
+    // The main thread should be counted to prevent thread oversubscription.
+    queue.StartWorkerThreads(GetNumCores() - 1);
+
+    const unsigned int flags{SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_TAPROOT};
+    bench.batch(INPUTS).unit("signature").run([&] {
+        std::vector<Check> checks;
+        checks.reserve(INPUTS);
+        for (size_t i = 0; i < INPUTS; ++i) {
+            // Not storing the results keeps the signature cache cold across iterations.
+            checks.emplace_back(CScriptCheck(txdata.m_spent_outputs[i], tx, i, flags, /*cacheIn=*/false, &txdata));
+        }
+        CCheckQueueControl<Check> control(&queue);
+        control.Add(checks);
+        assert(control.Wait());
+    });
+    queue.StopWorkerThreads();
+}
+
+static void SchnorrCheckQueueBatched(benchmark::Bench& bench) { SchnorrCheckQueue<CScriptCheck>(bench); }
+static void SchnorrCheckQueueUnbatched(benchmark::Bench& bench) { SchnorrCheckQueue<UnbatchedScriptCheck>(bench); }
+
+BENCHMARK(SchnorrCheckQueueBatched);
+BENCHMARK(SchnorrCheckQueueUnbatched);
@@ -0,0 +1,66 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <compat/compat.h>
+#include <util/sock.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#ifndef WIN32 // Windows does not have socketpair(2).
+
+using namespace std::chrono_literals;
+
+/** Number of connected peers that have nothing to say. */
+static constexpr size_t NUM_IDLE_SOCKETS{1000};
+
+/**
+ * Wait for readiness of many idle sockets and a single one that has data to read, the way the
+ * socket handler thread does on a node with many mostly idle peers.
+ */
+template <typename WaitFn>
+static void WaitManyIdle(benchmark::Bench& bench, WaitFn wait)
+{
+    std::vector<std::shared_ptr<const Sock>> socks;
+    Sock::EventsPerSock events_per_sock;
+    for (size_t i = 0; i < NUM_IDLE_SOCKETS + 1; ++i) {
+        int s[2];
+        const int ret{socketpair(AF_UNIX, SOCK_STREAM, 0, s)};
+        assert(ret == 0);
+        socks.push_back(std::make_shared<const Sock>(s[0]));
+        socks.push_back(std::make_shared<const Sock>(s[1]));
+        events_per_sock.emplace(socks.back(), Sock::Events{Sock::RECV});
+    }
+    const ssize_t sent{socks.front()->Send("a", 1, 0)};
+    assert(sent == 1);
+
+    bench.run([&] {
+        const bool ready{wait(events_per_sock)};
+        assert(ready);
+        assert(events_per_sock.at(socks[1]).occurred == Sock::RECV);
+    });
+}
+
+static void SockWaitManyPoll(benchmark::Bench& bench)
+{
+    WaitManyIdle(bench, [](Sock::EventsPerSock& events_per_sock) {
+        return events_per_sock.begin()->first->WaitMany(0ms, events_per_sock);
+    });
+}
+
+static void SockWaitManyWaitSet(benchmark::Bench& bench)
+{
+    SockWaitSet wait_set;
+    WaitManyIdle(bench, [&wait_set](Sock::EventsPerSock& events_per_sock) {
+        return wait_set.WaitMany(0ms, events_per_sock);
+    });
+}
+
+BENCHMARK(SockWaitManyPoll);
+BENCHMARK(SockWaitManyWaitSet);
+
+#endif // WIN32
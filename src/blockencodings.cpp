@@ -14,18 +14,25 @@
 #include <validation.h>
 #include <util/system.h>
 
+#include <array>
 #include <unordered_map>
 
+/** Weight of the top of the mempool by ancestor feerate that
+ * PartiallyDownloadedBlock::InitData looks at first. Twice a block, as
+ * miners' mempools differ from ours. */
+static constexpr int64_t MAX_SCAN_BY_SCORE_WEIGHT = 2 * MAX_BLOCK_WEIGHT;
+
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block) :
         nonce(GetRand<uint64_t>()),
         shorttxids(block.vtx.size() - 1), prefilledtxn(1), header(block) {
     FillShortTxIDSelector();
     //TODO: Use our mempool prior to block acceptance to predictively fill more than just the coinbase
     prefilledtxn[0] = {0, block.vtx[0]};
+    std::vector<const uint256*> wtxids(shorttxids.size());
     for (size_t i = 1; i < block.vtx.size(); i++) {
-        const CTransaction& tx = *block.vtx[i];
-        shorttxids[i - 1] = GetShortID(tx.GetWitnessHash());
+        wtxids[i - 1] = &block.vtx[i]->GetWitnessHash();
     }
+    GetShortIDs(wtxids.data(), shorttxids.data(), wtxids.size());
 }
 
 void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const {
@@ -44,6 +51,13 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+void CBlockHeaderAndShortTxIDs::GetShortIDs(const uint256* const txhashes[], uint64_t shortids[], size_t count) const {
+    SipHashUint256Batch(shorttxidk0, shorttxidk1, txhashes, shortids, count);
+    for (size_t i = 0; i < count; i++) {
+        shortids[i] &= 0xffffffffffffL;
+    }
+}
+
 
 
 ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
@@ -103,31 +117,70 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
         return READ_STATUS_FAILED; // Short ID collision
 
     std::vector<bool> have_txn(txn_available.size());
-    {
-    LOCK(pool->cs);
-    for (size_t i = 0; i < pool->vTxHashes.size(); i++) {
-        uint64_t shortid = cmpctblock.GetShortID(pool->vTxHashes[i].first);
+    const auto add_mempool_txn = [&](const uint256& wtxid, uint64_t shortid, const CTxMemPoolEntry& entry) {
         std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
         if (idit != shorttxids.end()) {
             if (!have_txn[idit->second]) {
-                txn_available[idit->second] = pool->vTxHashes[i].second->GetSharedTx();
+                txn_available[idit->second] = entry.GetSharedTx();
                 have_txn[idit->second]  = true;
                 mempool_count++;
             } else {
                 // If we find two mempool txn that match the short id, just request it.
                 // This should be rare enough that the extra bandwidth doesn't matter,
                 // but eating a round-trip due to FillBlock failure would be annoying
-                if (txn_available[idit->second]) {
+                // Transactions found in the first pass below are seen again in
+                // the second one, so compare witness hashes first
+                if (txn_available[idit->second] && txn_available[idit->second]->GetWitnessHash() != wtxid) {
                     txn_available[idit->second].reset();
                     mempool_count--;
                 }
             }
         }
+    };
+    // Short ids of mempool entries are computed MEMPOOL_BATCH_SIZE at a time.
+    static constexpr size_t MEMPOOL_BATCH_SIZE{16};
+    std::array<const uint256*, MEMPOOL_BATCH_SIZE> batch_wtxids;
+    std::array<const CTxMemPoolEntry*, MEMPOOL_BATCH_SIZE> batch_entries;
+    std::array<uint64_t, MEMPOOL_BATCH_SIZE> batch_shortids;
+    size_t batch_size{0};
+    const auto flush_batch = [&]() {
+        cmpctblock.GetShortIDs(batch_wtxids.data(), batch_shortids.data(), batch_size);
+        for (size_t i = 0; i < batch_size; i++) {
+            add_mempool_txn(*batch_wtxids[i], batch_shortids[i], *batch_entries[i]);
+        }
+        batch_size = 0;
+    };
+    {
+    LOCK(pool->cs);
+    // Miners select transactions by ancestor feerate, so most of a block is
+    // usually at the top of our mempool. Look there first: if we have every
+    // transaction, this finds them after about a block's worth of entries,
+    // instead of hashing every entry of the mempool below.
+    int64_t scanned_weight = 0;
+    const auto& by_ancestor_score = pool->mapTx.get<ancestor_score>();
+    for (auto it = by_ancestor_score.begin(); it != by_ancestor_score.end() && scanned_weight < MAX_SCAN_BY_SCORE_WEIGHT; ++it) {
+        batch_wtxids[batch_size] = &it->GetTx().GetWitnessHash();
+        batch_entries[batch_size++] = &*it;
+        scanned_weight += it->GetTxWeight();
+        if (batch_size == MEMPOOL_BATCH_SIZE) {
+            flush_batch();
+            if (mempool_count == shorttxids.size())
+                break;
+        }
+    }
+    flush_batch();
+
+    for (size_t i = 0; i < pool->vTxHashes.size(); i++) {
         // Though ideally we'd continue scanning for the two-txn-match-shortid case,
         // the performance win of an early exit here is too good to pass up and worth
         // the extra risk.
         if (mempool_count == shorttxids.size())
             break;
+        batch_wtxids[batch_size] = &pool->vTxHashes[i].first;
+        batch_entries[batch_size++] = &*pool->vTxHashes[i].second;
+        if (batch_size == MEMPOOL_BATCH_SIZE || i + 1 == pool->vTxHashes.size()) {
+            flush_batch();
+        }
     }
     }
 
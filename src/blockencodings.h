@@ -107,6 +107,8 @@ public:
     CBlockHeaderAndShortTxIDs(const CBlock& block);
 
     uint64_t GetShortID(const uint256& txhash) const;
+    /** Compute GetShortID(*txhashes[i]) into shortids[i] for i < count, several at a time. */
+    void GetShortIDs(const uint256* const txhashes[], uint64_t shortids[], size_t count) const;
 
     size_t BlockTxCount() const { return shorttxids.size() + prefilledtxn.size(); }
 
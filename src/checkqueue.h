@@ -11,26 +11,64 @@
 #include <util/threadnames.h>
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 template <typename T>
 class CCheckQueueControl;
 
+namespace checkqueue_detail {
+//! Batch type of verifications that do not define one.
+struct NoBatch {};
+
+template <typename T, typename = void>
+struct BatchOf {
+    using type = NoBatch;
+};
+template <typename T>
+struct BatchOf<T, std::void_t<typename T::Batch>> {
+    using type = typename T::Batch;
+};
+} // namespace checkqueue_detail
+
 /**
  * Queue for verifications that have to be performed.
   * The verifications are represented by a type T, which must provide an
   * operator(), returning a bool.
   *
+  * T may also define a Batch type, with Verify() and clear() members. Its
+  * operator()(Batch&) is called then instead, with one Batch shared by all
+  * verifications a worker takes from the queue at once, and followed by a
+  * call to Batch::Verify(). This allows deferring work, like signature
+  * checks, so that it can be done for many verifications together.
+  *
   * One thread (the master) is assumed to push batches of verifications
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every worker (including the master) has its own queue of verifications,
+  * which added verifications are spread over. A worker takes verifications
+  * from the back of its own queue, and when that is empty, steals from the
+  * front of the queue of another worker. This way workers only contend with
+  * each other when they run out of work, instead of on every batch.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! Verifications queued for one worker.
+    struct WorkerQueue {
+        Mutex m_mutex;
+        //! As the order of booleans doesn't matter, the owner uses it as a
+        //! LIFO (stack), while other workers steal from the front.
+        std::deque<T> m_checks GUARDED_BY(m_mutex);
+    };
+
+    //! Mutex to protect the state used by idle workers to wait for work
     Mutex m_mutex;
 
     //! Worker threads block on this when out of work
@@ -39,25 +77,28 @@ private:
     //! Master thread blocks on this when out of work
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
+    //! The queues of the workers, starting with the master's.
+    //! Only resized when no worker threads are running.
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+    //! Queue the next added verifications are put in first.
+    size_t m_next_queue{0};
+
+    //! The number of verifications in all queues.
+    std::atomic<unsigned int> m_num_queued{0};
 
     //! The number of workers (including the master) that are idle.
     int nIdle GUARDED_BY(m_mutex){0};
 
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
-
     //! The temporary evaluation result.
-    bool fAllOk GUARDED_BY(m_mutex){true};
+    std::atomic<bool> fAllOk{true};
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    std::atomic<unsigned int> nTodo{0};
 
     //! The maximum number of elements to be processed in one batch
     const unsigned int nBatchSize;
@@ -65,67 +106,102 @@ private:
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    /**
+     * Move a batch of verifications to vChecks, from the queue of worker
+     * index if possible, or else from the queue of another worker.
+     *
+     * The batch size adapts to the amount of queued work: batches get
+     * smaller as the queues drain, so all workers finish approximately
+     * simultaneously, and are never larger than nBatchSize.
+     */
+    void TakeChecks(size_t index, std::vector<T>& vChecks)
+    {
+        {
+            WorkerQueue& own{*m_queues[index]};
+            LOCK(own.m_mutex);
+            if (!own.m_checks.empty()) {
+                const size_t target{m_num_queued.load(std::memory_order_relaxed) / (2 * m_queues.size())};
+                const size_t nNow{std::min(own.m_checks.size(), std::clamp<size_t>(target, 1, nBatchSize))};
+                vChecks.resize(nNow);
+                for (T& check : vChecks) {
+                    // Swap jobs to the local batch vector instead of copying.
+                    check.swap(own.m_checks.back());
+                    own.m_checks.pop_back();
+                }
+                m_num_queued -= nNow;
+                return;
+            }
+        }
+        for (size_t i = 1; i < m_queues.size(); ++i) {
+            WorkerQueue& victim{*m_queues[(index + i) % m_queues.size()]};
+            LOCK(victim.m_mutex);
+            if (victim.m_checks.empty()) continue;
+            // Steal half of the victim's work, leaving it the other half.
+            const size_t nNow{std::min<size_t>(nBatchSize, (victim.m_checks.size() + 1) / 2)};
+            vChecks.resize(nNow);
+            for (T& check : vChecks) {
+                check.swap(victim.m_checks.front());
+                victim.m_checks.pop_front();
+            }
+            m_num_queued -= nNow;
+            return;
+        }
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    bool Loop(size_t index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
+        const bool fMaster{index == 0};
         std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
+        using Batch = typename checkqueue_detail::BatchOf<T>::type;
+        [[maybe_unused]] Batch batch;
         do {
-            {
+            TakeChecks(index, vChecks);
+            if (vChecks.empty()) {
                 WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
+                if (m_request_stop) {
+                    return false;
+                }
+                if (fMaster && nTodo == 0) {
+                    // return the current status, and reset it for new work later
+                    return fAllOk.exchange(true);
                 }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
+                // The master only waits for the workers to finish, as it does
+                // not add new work while waiting.
+                if (fMaster || m_num_queued == 0) {
                     nIdle++;
                     cond.wait(lock); // wait
                     nIdle--;
                 }
-                if (m_request_stop) {
-                    return false;
-                }
-
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the m_mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                continue;
             }
+            const unsigned int nNow = vChecks.size();
+            // Check whether we need to do work at all
+            bool fOk = fAllOk;
             // execute work
-            for (T& check : vChecks)
+            if constexpr (std::is_same_v<Batch, checkqueue_detail::NoBatch>) {
+                for (T& check : vChecks)
+                    if (fOk)
+                        fOk = check();
+            } else {
+                for (T& check : vChecks)
+                    if (fOk)
+                        fOk = check(batch);
                 if (fOk)
-                    fOk = check();
+                    fOk = batch.Verify();
+                batch.clear();
+            }
+            if (!fOk) fAllOk = false;
             vChecks.clear();
+            if (nTodo.fetch_sub(nNow) == nNow && !fMaster) {
+                // We processed the last element; inform the master it can exit
+                // and return the result. Taking the lock makes sure it is
+                // either waiting already or sees nTodo == 0.
+                LOCK(m_mutex);
+                m_master_cv.notify_one();
+            }
         } while (true);
     }
 
@@ -137,6 +213,7 @@ public:
     explicit CCheckQueue(unsigned int nBatchSizeIn)
         : nBatchSize(nBatchSizeIn)
     {
+        m_queues.emplace_back(std::make_unique<WorkerQueue>());
     }
 
     //! Create a pool of new worker threads.
@@ -145,15 +222,20 @@ public:
         {
             LOCK(m_mutex);
             nIdle = 0;
-            nTotal = 0;
-            fAllOk = true;
         }
+        fAllOk = true;
         assert(m_worker_threads.empty());
+        assert(m_num_queued == 0);
+        m_queues.resize(1);
+        for (int n = 0; n < threads_num; ++n) {
+            m_queues.emplace_back(std::make_unique<WorkerQueue>());
+        }
+        m_next_queue = 0;
         for (int n = 0; n < threads_num; ++n) {
             m_worker_threads.emplace_back([this, n]() {
                 util::ThreadRename(strprintf("scriptch.%i", n));
                 SetSyscallSandboxPolicy(SyscallSandboxPolicy::VALIDATION_SCRIPT_CHECK);
-                Loop(false /* worker thread */);
+                Loop(n + 1 /* worker thread */);
             });
         }
     }
@@ -161,7 +243,7 @@ public:
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        return Loop(true /* master thread */);
+        return Loop(0 /* master thread */);
     }
 
     //! Add a batch of checks to the queue
@@ -171,15 +253,30 @@ public:
             return;
         }
 
-        {
-            LOCK(m_mutex);
-            for (T& check : vChecks) {
-                queue.emplace_back();
-                check.swap(queue.back());
+        // Count the checks before queueing them, so the count cannot drop
+        // to zero before all of them are done.
+        nTodo += vChecks.size();
+
+        // Spread the checks evenly over the queues, in consecutive slices so
+        // that checks added together are likely verified by the same worker.
+        const size_t slice{(vChecks.size() + m_queues.size() - 1) / m_queues.size()};
+        for (size_t begin = 0; begin < vChecks.size(); begin += slice) {
+            const size_t end{std::min(begin + slice, vChecks.size())};
+            WorkerQueue& queue{*m_queues[m_next_queue]};
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+            LOCK(queue.m_mutex);
+            for (size_t i = begin; i < end; ++i) {
+                queue.m_checks.emplace_back();
+                vChecks[i].swap(queue.m_checks.back());
             }
-            nTodo += vChecks.size();
+            m_num_queued += end - begin;
         }
 
+        // Taking the lock makes sure idle workers are either waiting already
+        // or see the new work.
+        if (WITH_LOCK(m_mutex, return nIdle) == 0) {
+            return;
+        }
         if (vChecks.size() == 1) {
             m_worker_cv.notify_one();
         } else {
@@ -7,9 +7,13 @@
 #include <consensus/consensus.h>
 #include <logging.h>
 #include <random.h>
+#include <util/threadpool.h>
 #include <util/trace.h>
 #include <version.h>
 
+#include <algorithm>
+#include <optional>
+
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return false; }
 uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
@@ -254,6 +258,50 @@ void CCoinsViewCache::Uncache(const COutPoint& hash)
     }
 }
 
+size_t CCoinsViewCache::PrefetchCoins(std::vector<COutPoint> outpoints, ThreadPool& pool)
+{
+    const int workers{pool.WorkersCount()};
+    if (workers == 0) return 0;
+
+    outpoints.erase(std::remove_if(outpoints.begin(), outpoints.end(),
+                                   [&](const COutPoint& outpoint) { return cacheCoins.count(outpoint); }),
+                    outpoints.end());
+    if (outpoints.empty()) return 0;
+    // Sorted outpoints map to (nearly) ascending database keys, which keeps
+    // each batch's lookups close together on disk.
+    std::sort(outpoints.begin(), outpoints.end());
+
+    // Hand out a few batches per worker so that a batch of slow lookups does
+    // not hold up the others.
+    const size_t batch_size{std::max<size_t>(1, outpoints.size() / (workers * 4))};
+    std::vector<std::optional<Coin>> results(outpoints.size());
+    std::vector<std::future<void>> batches;
+    for (size_t begin = 0; begin < outpoints.size(); begin += batch_size) {
+        const size_t end{std::min(begin + batch_size, outpoints.size())};
+        batches.push_back(pool.Submit([this, &outpoints, &results, begin, end]() {
+            for (size_t i = begin; i < end; ++i) {
+                Coin coin;
+                if (base->GetCoin(outpoints[i], coin)) results[i] = std::move(coin);
+            }
+        }));
+    }
+    // Wait for all batches before rethrowing any read error, as the pending
+    // ones still reference the vectors above.
+    for (auto& batch : batches) batch.wait();
+    for (auto& batch : batches) batch.get();
+
+    size_t added{0};
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (!results[i]) continue;
+        auto [it, inserted] = cacheCoins.try_emplace(outpoints[i], std::move(*results[i]));
+        if (inserted) {
+            cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+            ++added;
+        }
+    }
+    return added;
+}
+
 unsigned int CCoinsViewCache::GetCacheSize() const {
     return cacheCoins.size();
 }
@@ -8,6 +8,7 @@
 
 #include <compressor.h>
 #include <core_memusage.h>
+#include <flathashmap.h>
 #include <memusage.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
@@ -18,7 +19,8 @@
 #include <stdint.h>
 
 #include <functional>
-#include <unordered_map>
+
+class ThreadPool;
 
 /**
  * A UTXO entry.
@@ -131,7 +133,12 @@ struct CCoinsCacheEntry
     CCoinsCacheEntry(Coin&& coin_, unsigned char flag) : coin(std::move(coin_)), flags(flag) {}
 };
 
-typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
+/**
+ * Map of the cached coins. It uses open addressing, so entries are stored
+ * inline instead of in one heap node each. Note that inserting a coin may
+ * invalidate references to other entries.
+ */
+typedef FlatHashMap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -294,6 +301,17 @@ public:
      */
     void Uncache(const COutPoint &outpoint);
 
+    /**
+     * Load the given outpoints into the cache ahead of their use. Lookups for
+     * outpoints not already cached are split into batches and performed by
+     * the workers of the passed pool, so the backing view must support
+     * concurrent GetCoin calls. Outpoints missing from the backing view are
+     * ignored.
+     *
+     * @returns the number of coins that were added to the cache
+     */
+    size_t PrefetchCoins(std::vector<COutPoint> outpoints, ThreadPool& pool);
+
     //! Calculate the size of the cache (in number of transaction outputs)
     unsigned int GetCacheSize() const;
 
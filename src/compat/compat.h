@@ -107,6 +107,7 @@ typedef char* sockopt_arg_type;
 // __APPLE__ poll is broke https://github.com/bitcoin/bitcoin/pull/14336#issuecomment-437384408
 #if defined(__linux__)
 #define USE_POLL
+#define USE_EPOLL
 #endif
 
 // MSG_NOSIGNAL is not available on some platforms, if it doesn't exist define it as 0
@@ -4,6 +4,16 @@
 
 #include <crypto/siphash.h>
 
+#include <compat/cpuid.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace siphash_avx2
+{
+void Uint256_8way(uint64_t k0, uint64_t k1, const uint256* const vals[8], uint64_t out[8]);
+}
+
 #define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
 
 #define SIPROUND do { \
@@ -171,3 +181,90 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+namespace {
+
+typedef void (*Uint256BatchType)(uint64_t, uint64_t, const uint256* const*, uint64_t*);
+
+Uint256BatchType Uint256_8way = nullptr;
+
+bool SelfTest()
+{
+    uint256 vals[8];
+    const uint256* ptrs[8];
+    uint64_t expected[8];
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 32; ++j) vals[i].begin()[j] = i * 32 + j;
+        ptrs[i] = &vals[i];
+        expected[i] = SipHashUint256(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, vals[i]);
+    }
+
+    // Test Uint256_8way, if available.
+    if (Uint256_8way) {
+        uint64_t out[8];
+        Uint256_8way(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, ptrs, out);
+        if (!std::equal(out, out + 8, expected)) return false;
+    }
+
+    return true;
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+} // namespace
+
+std::string SipHashAutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+    // There is no 64-bit vector rotate before AVX-512, so a 2-lane SSE4.1 kernel is not faster than the
+    // scalar code.
+    [[maybe_unused]] bool have_avx2 = false;
+    [[maybe_unused]] bool enabled_avx = false;
+
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        enabled_avx = AVXEnabled();
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2 && enabled_avx) {
+        Uint256_8way = siphash_avx2::Uint256_8way;
+        ret = "avx2(8way)";
+    }
+#endif
+#endif // defined(USE_ASM) && defined(HAVE_GETCPUID)
+
+    assert(SelfTest());
+    return ret;
+}
+
+void SipHashUint256Batch(uint64_t k0, uint64_t k1, const uint256* const vals[], uint64_t out[], size_t count)
+{
+    if (Uint256_8way) {
+        while (count >= 8) {
+            Uint256_8way(k0, k1, vals, out);
+            vals += 8;
+            out += 8;
+            count -= 8;
+        }
+    }
+    while (count > 0) {
+        *out = SipHashUint256(k0, k1, **vals);
+        ++vals;
+        ++out;
+        --count;
+    }
+}
@@ -6,6 +6,8 @@
 #define BITCOIN_CRYPTO_SIPHASH_H
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string>
 
 #include <uint256.h>
 
@@ -44,4 +46,16 @@ public:
 uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint32_t extra);
 
+/** Compute out[i] = SipHashUint256(k0, k1, *vals[i]) for i < count.
+ *
+ *  Hashes several values at once if a multi-lane implementation was selected
+ *  by SipHashAutoDetect(), so prefer it over a loop of SipHashUint256 calls.
+ */
+void SipHashUint256Batch(uint64_t k0, uint64_t k1, const uint256* const vals[], uint64_t out[], size_t count);
+
+/** Autodetect the best available SipHash batch implementation.
+ *  Returns the name of the implementation.
+ */
+std::string SipHashAutoDetect();
+
 #endif // BITCOIN_CRYPTO_SIPHASH_H
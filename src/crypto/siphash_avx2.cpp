@@ -0,0 +1,104 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <uint256.h>
+
+namespace siphash_avx2 {
+namespace {
+
+__m256i inline K(uint64_t x) { return _mm256_set1_epi64x(x); }
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi64(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+template <int n>
+__m256i inline RotL(__m256i x) { return _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n)); }
+template <>
+__m256i inline RotL<32>(__m256i x) { return _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)); }
+template <>
+__m256i inline RotL<16>(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_setr_epi8(6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13, 6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13)); }
+
+/** SipHash state of 4 lanes per vector, with N vectors processed in an interleaved way. */
+template <int N>
+struct State {
+    __m256i v0[N], v1[N], v2[N], v3[N];
+};
+
+template <int N>
+void inline __attribute__((always_inline)) SipRound(State<N>& s)
+{
+    for (int i = 0; i < N; ++i) {
+        s.v0[i] = Add(s.v0[i], s.v1[i]); s.v1[i] = RotL<13>(s.v1[i]); s.v1[i] = Xor(s.v1[i], s.v0[i]);
+        s.v0[i] = RotL<32>(s.v0[i]);
+        s.v2[i] = Add(s.v2[i], s.v3[i]); s.v3[i] = RotL<16>(s.v3[i]); s.v3[i] = Xor(s.v3[i], s.v2[i]);
+        s.v0[i] = Add(s.v0[i], s.v3[i]); s.v3[i] = RotL<21>(s.v3[i]); s.v3[i] = Xor(s.v3[i], s.v0[i]);
+        s.v2[i] = Add(s.v2[i], s.v1[i]); s.v1[i] = RotL<17>(s.v1[i]); s.v1[i] = Xor(s.v1[i], s.v2[i]);
+        s.v2[i] = RotL<32>(s.v2[i]);
+    }
+}
+
+template <int N>
+void inline __attribute__((always_inline)) Compress(State<N>& s, const __m256i (&d)[N])
+{
+    for (int i = 0; i < N; ++i) s.v3[i] = Xor(s.v3[i], d[i]);
+    SipRound(s);
+    SipRound(s);
+    for (int i = 0; i < N; ++i) s.v0[i] = Xor(s.v0[i], d[i]);
+}
+
+/** Load word j of 4 uint256 values at a time into the lanes of w[j]. */
+void inline __attribute__((always_inline)) Load(const uint256* const vals[4], __m256i (&w)[4])
+{
+    __m256i r0 = _mm256_loadu_si256((const __m256i*)vals[0]->begin());
+    __m256i r1 = _mm256_loadu_si256((const __m256i*)vals[1]->begin());
+    __m256i r2 = _mm256_loadu_si256((const __m256i*)vals[2]->begin());
+    __m256i r3 = _mm256_loadu_si256((const __m256i*)vals[3]->begin());
+    __m256i t0 = _mm256_unpacklo_epi64(r0, r1);
+    __m256i t1 = _mm256_unpackhi_epi64(r0, r1);
+    __m256i t2 = _mm256_unpacklo_epi64(r2, r3);
+    __m256i t3 = _mm256_unpackhi_epi64(r2, r3);
+    w[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+    w[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+    w[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+    w[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+} // namespace
+
+void Uint256_8way(uint64_t k0, uint64_t k1, const uint256* const vals[8], uint64_t out[8])
+{
+    __m256i w[2][4];
+    Load(vals, w[0]);
+    Load(vals + 4, w[1]);
+
+    State<2> s;
+    for (int i = 0; i < 2; ++i) {
+        s.v0[i] = K(0x736f6d6570736575ULL ^ k0);
+        s.v1[i] = K(0x646f72616e646f6dULL ^ k1);
+        s.v2[i] = K(0x6c7967656e657261ULL ^ k0);
+        s.v3[i] = K(0x7465646279746573ULL ^ k1);
+    }
+    for (int j = 0; j < 4; ++j) {
+        const __m256i d[2] = {w[0][j], w[1][j]};
+        Compress(s, d);
+    }
+    const __m256i d[2] = {K(((uint64_t)4) << 59), K(((uint64_t)4) << 59)};
+    Compress(s, d);
+    for (int i = 0; i < 2; ++i) s.v2[i] = Xor(s.v2[i], K(0xFF));
+    SipRound(s);
+    SipRound(s);
+    SipRound(s);
+    SipRound(s);
+    for (int i = 0; i < 2; ++i) {
+        _mm256_storeu_si256((__m256i*)(out + 4 * i), Xor(Xor(s.v0[i], s.v1[i]), Xor(s.v2[i], s.v3[i])));
+    }
+}
+
+} // namespace siphash_avx2
+
+#endif
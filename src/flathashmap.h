@@ -0,0 +1,370 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_FLATHASHMAP_H
+#define BITCOIN_FLATHASHMAP_H
+
+#include <util/fastrange.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/** Hash map using open addressing, storing its elements inline in one array.
+ *
+ * Compared to std::unordered_map, which allocates a separate node per element
+ * and reaches it through a bucket pointer, a lookup here usually touches a
+ * single cache line of metadata and a single element.
+ *
+ * Every slot has a control byte that is either empty, deleted (a tombstone)
+ * or holds 7 bits of the hash of the element stored in the slot. Lookups
+ * probe linearly from the slot the hash is mapped to, and only compare keys
+ * for slots whose control byte matches.
+ *
+ * The table is kept up to 90% full and grows by 25% at a time (which is
+ * possible as the capacity does not need to be a power of two), so that the
+ * memory used per element stays close to the size of the element itself.
+ *
+ * The interface is the subset of std::unordered_map used by the code, with
+ * these differences:
+ * - Inserting an element may invalidate all iterators and references to
+ *   elements (like a rehash of std::unordered_map, which however preserves
+ *   references).
+ * - Erasing an element leaves a tombstone and never moves other elements, so
+ *   both erase(it++) and it = erase(it) can be used while iterating.
+ * - clear() releases the table, as it makes up most of the memory used.
+ * - The map can be neither copied nor moved.
+ */
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap
+{
+public:
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef size_t size_type;
+    typedef Hash hasher;
+    typedef KeyEqual key_equal;
+
+private:
+    static constexpr int8_t CTRL_EMPTY{-128};
+    static constexpr int8_t CTRL_DELETED{-2};
+    //! Capacity of the table allocated on first insertion.
+    static constexpr size_t MIN_CAPACITY{8};
+    static constexpr size_t NPOS{std::numeric_limits<size_t>::max()};
+
+    //! Uninitialized storage for one element.
+    union Slot {
+        Slot() {}
+        ~Slot() {}
+        value_type value;
+    };
+
+    const Hash m_hash{};
+    const KeyEqual m_equal{};
+    size_t m_capacity{0};
+    size_t m_size{0};
+    //! Number of tombstones left behind by erasures.
+    size_t m_deleted{0};
+    int8_t* m_ctrl{nullptr};
+    Slot* m_slots{nullptr};
+
+    static bool IsFull(int8_t ctrl) { return ctrl >= 0; }
+    //! The slot index is taken from the high bits of the hash, the tag from the low bits.
+    static int8_t Tag(size_t hash) { return int8_t(hash & 0x7f); }
+
+    size_t Home(size_t hash) const
+    {
+        if constexpr (sizeof(size_t) == 8) {
+            return FastRange64(hash, m_capacity);
+        } else {
+            return FastRange32(hash, m_capacity);
+        }
+    }
+    size_t Next(size_t index) const { return index + 1 == m_capacity ? 0 : index + 1; }
+
+    //! Maximum number of full and deleted slots before the table has to be
+    //! rehashed. At least one slot is always left empty.
+    static size_t MaxLoad(size_t capacity) { return capacity * 9 / 10; }
+
+    size_t FindIndex(const Key& key, size_t hash) const
+    {
+        if (m_capacity == 0) return NPOS;
+        const int8_t tag{Tag(hash)};
+        // Terminates as the load limit guarantees at least one empty slot.
+        for (size_t i = Home(hash);; i = Next(i)) {
+            if (m_ctrl[i] == tag && m_equal(m_slots[i].value.first, key)) return i;
+            if (m_ctrl[i] == CTRL_EMPTY) return NPOS;
+        }
+    }
+
+    //! Find the first empty or deleted slot in the probe sequence of hash.
+    size_t FindInsertIndex(size_t hash) const
+    {
+        for (size_t i = Home(hash);; i = Next(i)) {
+            if (!IsFull(m_ctrl[i])) return i;
+        }
+    }
+
+    void Allocate(size_t capacity)
+    {
+        m_ctrl = new int8_t[capacity];
+        std::memset(m_ctrl, CTRL_EMPTY, capacity);
+        m_slots = std::allocator<Slot>().allocate(capacity);
+        m_capacity = capacity;
+    }
+
+    void Deallocate()
+    {
+        if (m_capacity == 0) return;
+        delete[] m_ctrl;
+        std::allocator<Slot>().deallocate(m_slots, m_capacity);
+        m_ctrl = nullptr;
+        m_slots = nullptr;
+        m_capacity = 0;
+    }
+
+    void DestroyElements()
+    {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_t i = 0; i < m_capacity; ++i) {
+                if (IsFull(m_ctrl[i])) m_slots[i].value.~value_type();
+            }
+        }
+    }
+
+    //! Move all elements into a new table of the given capacity, dropping all tombstones.
+    void Rehash(size_t new_capacity)
+    {
+        assert(MaxLoad(new_capacity) > m_size);
+        const size_t old_capacity{m_capacity};
+        int8_t* const old_ctrl{m_ctrl};
+        Slot* const old_slots{m_slots};
+        Allocate(new_capacity);
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (!IsFull(old_ctrl[i])) continue;
+            value_type& value{old_slots[i].value};
+            const size_t hash{m_hash(value.first)};
+            const size_t index{FindInsertIndex(hash)};
+            new (&m_slots[index].value) value_type(std::move(value));
+            m_ctrl[index] = Tag(hash);
+            value.~value_type();
+        }
+        m_deleted = 0;
+        if (old_capacity) {
+            delete[] old_ctrl;
+            std::allocator<Slot>().deallocate(old_slots, old_capacity);
+        }
+    }
+
+    //! Make sure one more element can be inserted without exceeding the load limit.
+    void PrepareInsert()
+    {
+        if (m_size + m_deleted + 1 <= MaxLoad(m_capacity)) return;
+        if (m_capacity == 0) {
+            Rehash(MIN_CAPACITY);
+        } else if ((m_size + 1) * 2 <= MaxLoad(m_capacity)) {
+            // Mostly tombstones: clean them up without growing.
+            Rehash(m_capacity);
+        } else {
+            Rehash(m_capacity + m_capacity / 4);
+        }
+    }
+
+    template <bool IsConst>
+    class Iter
+    {
+        friend class FlatHashMap;
+        template <bool>
+        friend class Iter;
+        using Map = std::conditional_t<IsConst, const FlatHashMap, FlatHashMap>;
+
+        Map* m_map{nullptr};
+        size_t m_index{0};
+
+        Iter(Map* map, size_t index) : m_map(map), m_index(index) {}
+
+        void SkipToFull()
+        {
+            while (m_index < m_map->m_capacity && !IsFull(m_map->m_ctrl[m_index])) ++m_index;
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef FlatHashMap::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::conditional_t<IsConst, const value_type*, value_type*> pointer;
+        typedef std::conditional_t<IsConst, const value_type&, value_type&> reference;
+
+        Iter() = default;
+        template <bool C = IsConst, typename = std::enable_if_t<C>>
+        Iter(const Iter<false>& other) : m_map(other.m_map), m_index(other.m_index) {}
+
+        reference operator*() const { return m_map->m_slots[m_index].value; }
+        pointer operator->() const { return &m_map->m_slots[m_index].value; }
+        Iter& operator++()
+        {
+            ++m_index;
+            SkipToFull();
+            return *this;
+        }
+        Iter operator++(int)
+        {
+            Iter copy{*this};
+            ++*this;
+            return copy;
+        }
+        friend bool operator==(const Iter& a, const Iter& b) { return a.m_index == b.m_index; }
+        friend bool operator!=(const Iter& a, const Iter& b) { return a.m_index != b.m_index; }
+    };
+
+public:
+    typedef Iter<false> iterator;
+    typedef Iter<true> const_iterator;
+
+    FlatHashMap() = default;
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+    ~FlatHashMap()
+    {
+        DestroyElements();
+        Deallocate();
+    }
+
+    iterator begin()
+    {
+        iterator it{this, 0};
+        it.SkipToFull();
+        return it;
+    }
+    const_iterator begin() const
+    {
+        const_iterator it{this, 0};
+        it.SkipToFull();
+        return it;
+    }
+    iterator end() { return {this, m_capacity}; }
+    const_iterator end() const { return {this, m_capacity}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    bool empty() const { return m_size == 0; }
+    size_type size() const { return m_size; }
+    //! Number of slots in the table.
+    size_type bucket_count() const { return m_capacity; }
+
+    iterator find(const Key& key)
+    {
+        const size_t index{FindIndex(key, m_hash(key))};
+        return index == NPOS ? end() : iterator{this, index};
+    }
+    const_iterator find(const Key& key) const
+    {
+        const size_t index{FindIndex(key, m_hash(key))};
+        return index == NPOS ? end() : const_iterator{this, index};
+    }
+    size_type count(const Key& key) const { return FindIndex(key, m_hash(key)) == NPOS ? 0 : 1; }
+
+    T& at(const Key& key)
+    {
+        const auto it{find(key)};
+        if (it == end()) throw std::out_of_range("FlatHashMap::at");
+        return it->second;
+    }
+    const T& at(const Key& key) const
+    {
+        const auto it{find(key)};
+        if (it == end()) throw std::out_of_range("FlatHashMap::at");
+        return it->second;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        size_t hash{m_hash(key)};
+        size_t index{FindIndex(key, hash)};
+        if (index != NPOS) return {iterator{this, index}, false};
+        PrepareInsert();
+        index = FindInsertIndex(hash);
+        new (&m_slots[index].value) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        if (m_ctrl[index] == CTRL_DELETED) --m_deleted;
+        m_ctrl[index] = Tag(hash);
+        ++m_size;
+        return {iterator{this, index}, true};
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> emplace(const Key& key, M&& mapped)
+    {
+        return try_emplace(key, std::forward<M>(mapped));
+    }
+
+    template <typename... KeyArgs, typename... Args>
+    std::pair<iterator, bool> emplace(std::piecewise_construct_t, std::tuple<KeyArgs...> key_args, std::tuple<Args...> args)
+    {
+        const Key key{std::make_from_tuple<Key>(std::move(key_args))};
+        return std::apply([&](auto&&... a) { return try_emplace(key, std::forward<decltype(a)>(a)...); }, std::move(args));
+    }
+
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    //! Erase the element at pos and return an iterator to the next element.
+    iterator erase(const_iterator pos)
+    {
+        const size_t index{pos.m_index};
+        assert(index < m_capacity && IsFull(m_ctrl[index]));
+        m_slots[index].value.~value_type();
+        // A slot followed by an empty one is never passed over by a probe
+        // sequence, so it can be marked empty instead of deleted.
+        if (m_ctrl[Next(index)] == CTRL_EMPTY) {
+            m_ctrl[index] = CTRL_EMPTY;
+        } else {
+            m_ctrl[index] = CTRL_DELETED;
+            ++m_deleted;
+        }
+        --m_size;
+        iterator next{this, index};
+        ++next;
+        return next;
+    }
+    iterator erase(iterator pos) { return erase(const_iterator{pos}); }
+
+    size_type erase(const Key& key)
+    {
+        const auto it{find(key)};
+        if (it == end()) return 0;
+        erase(it);
+        return 1;
+    }
+
+    //! Remove all elements and release the table.
+    void clear()
+    {
+        DestroyElements();
+        Deallocate();
+        m_size = 0;
+        m_deleted = 0;
+    }
+
+    //! Grow the table so that count elements can be held without rehashing.
+    void reserve(size_type count)
+    {
+        size_t capacity{std::max(m_capacity, MIN_CAPACITY)};
+        while (MaxLoad(capacity) <= count) capacity += capacity / 4;
+        if (capacity != m_capacity) Rehash(capacity);
+    }
+};
+
+#endif // BITCOIN_FLATHASHMAP_H
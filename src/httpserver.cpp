@@ -515,7 +515,11 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_re
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (m_reply_started && !replySent) {
+        // A chunked reply can only be cut short, not replaced by an error
+        LogPrintf("%s: Unfinished reply\n", __func__);
+        WriteReplyEnd();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -561,6 +565,20 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+/** Re-enable reading from the socket. This is the second part of the libevent
+ * workaround in http_request_cb. */
+static void ReenableReading(evhttp_connection* conn)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /** Closure sent to main thread to request a reply to be sent to
  * a HTTP request.
  * Replies must be sent in the main loop in the main http thread,
@@ -579,17 +597,55 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
-        }
+        ReenableReading(evhttp_request_get_connection(req_copy));
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+void HTTPRequest::WriteReplyStart(int nStatus)
+{
+    assert(!replySent && !m_reply_started && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    // The reply, its chunks and its end are all sent from the main http
+    // thread. Its events run in the order in which they are triggered, and
+    // libevent keeps the request alive until the end is sent, even if the
+    // connection is closed before.
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+    m_reply_started = true;
+}
+
+void HTTPRequest::WriteReplyChunk(std::string chunk)
+{
+    assert(m_reply_started && !replySent && req);
+    if (chunk.empty()) return; // an empty chunk would end the reply
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, chunk = std::move(chunk)]{
+        struct evbuffer* evb = evbuffer_new();
+        assert(evb);
+        evbuffer_add(evb, chunk.data(), chunk.size());
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::WriteReplyEnd()
+{
+    assert(m_reply_started && !replySent && req);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy]{
+        // Re-enable reading first, as evhttp_send_reply_end may free the
+        // request and its connection.
+        ReenableReading(evhttp_request_get_connection(req_copy));
+        evhttp_send_reply_end(req_copy);
     });
     ev->trigger(nullptr);
     replySent = true;
@@ -58,6 +58,7 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool m_reply_started{false};
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -124,6 +125,30 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a chunked HTTP reply, as an alternative to WriteReply for
+     * replies that are too large to build in memory first.
+     * nStatus is the HTTP status code to send. The body is passed with
+     * WriteReplyChunk, and the reply must be finished with WriteReplyEnd.
+     *
+     * @note Call WriteHeader before this, and call this only once.
+     */
+    void WriteReplyStart(int nStatus);
+
+    /**
+     * Send the next part of the body of a reply started with WriteReplyStart.
+     * Parts are sent in the order in which they are written.
+     */
+    void WriteReplyChunk(std::string chunk);
+
+    /**
+     * Finish a reply started with WriteReplyStart.
+     *
+     * @note As this will give the request back to the main thread, do not
+     * call any other HTTPRequest methods after calling this.
+     */
+    void WriteReplyEnd();
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -68,7 +68,8 @@ CDataStream TxOutSer(const COutPoint& outpoint, const Coin& coin) {
 //! It is also possible, though very unlikely, that a change in this
 //! construction could cause a previously invalid (and potentially malicious)
 //! UTXO snapshot to be considered valid.
-static void ApplyHash(HashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+template <typename Stream>
+static void SerializeHashedOutputs(Stream& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     for (auto it = outputs.begin(); it != outputs.end(); ++it) {
         if (it == outputs.begin()) {
@@ -86,6 +87,16 @@ static void ApplyHash(HashWriter& ss, const uint256& hash, const std::map<uint32
     }
 }
 
+void TxOutputsHashSer(CVectorWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    SerializeHashedOutputs(ss, hash, outputs);
+}
+
+static void ApplyHash(HashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    SerializeHashedOutputs(ss, hash, outputs);
+}
+
 static void ApplyHash(std::nullptr_t, const uint256& hash, const std::map<uint32_t, Coin>& outputs) {}
 
 static void ApplyHash(MuHash3072& muhash, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
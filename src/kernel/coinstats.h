@@ -11,6 +11,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <optional>
 
 class CCoinsView;
@@ -74,6 +75,11 @@ uint64_t GetBogoSize(const CScript& script_pub_key);
 
 CDataStream TxOutSer(const COutPoint& outpoint, const Coin& coin);
 
+//! Append what the HASH_SERIALIZED hash commits to for the unspent outputs
+//! of one transaction, so the hash can be computed from other sources than
+//! a coins view.
+void TxOutputsHashSer(CVectorWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs);
+
 std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
 } // namespace kernel
 
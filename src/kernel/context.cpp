@@ -5,6 +5,7 @@
 #include <kernel/context.h>
 
 #include <crypto/sha256.h>
+#include <crypto/siphash.h>
 #include <key.h>
 #include <logging.h>
 #include <pubkey.h>
@@ -19,6 +20,8 @@ Context::Context()
 {
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string siphash_algo = SipHashAutoDetect();
+    LogPrintf("Using the '%s' SipHash implementation\n", siphash_algo);
     RandomInit();
     ECC_Start();
     ecc_verify_handle.reset(new ECCVerifyHandle());
@@ -22,6 +22,8 @@ static constexpr unsigned int DEFAULT_MAX_MEMPOOL_SIZE_MB{300};
 static constexpr unsigned int DEFAULT_MEMPOOL_EXPIRY_HOURS{336};
 /** Default for -mempoolfullrbf, if the transaction replaceability signaling is ignored */
 static constexpr bool DEFAULT_MEMPOOL_FULL_RBF{false};
+/** Default for -mempoolclusters, if the mempool groups connected transactions into linearized clusters */
+static constexpr bool DEFAULT_MEMPOOL_CLUSTERS{false};
 
 namespace kernel {
 /**
@@ -53,6 +55,7 @@ struct MemPoolOptions {
     bool permit_bare_multisig{DEFAULT_PERMIT_BAREMULTISIG};
     bool require_standard{true};
     bool full_rbf{DEFAULT_MEMPOOL_FULL_RBF};
+    bool track_clusters{DEFAULT_MEMPOOL_CLUSTERS};
     MemPoolLimits limits{};
 };
 } // namespace kernel
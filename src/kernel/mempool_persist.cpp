@@ -7,7 +7,9 @@
 #include <clientversion.h>
 #include <consensus/amount.h>
 #include <fs.h>
+#include <hash.h>
 #include <logging.h>
+#include <policy/policy.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
 #include <shutdown.h>
@@ -35,7 +37,12 @@ using fsbridge::FopenFn;
 
 namespace kernel {
 
-static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+static const uint64_t MEMPOOL_DUMP_VERSION_NO_SCRIPT_FLAGS{1};
+/**
+ * Since this version, the file records the script verification flags that
+ * its transactions were checked against, and ends with a checksum.
+ */
+static const uint64_t MEMPOOL_DUMP_VERSION{2};
 
 bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active_chainstate, FopenFn mockable_fopen_function)
 {
@@ -49,6 +56,7 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
     }
 
     int64_t count = 0;
+    int64_t unchecked = 0;
     int64_t expired = 0;
     int64_t failed = 0;
     int64_t already_there = 0;
@@ -56,37 +64,77 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
     auto now = NodeClock::now();
 
     try {
+        CHashVerifier<CAutoFile> verifier{&file};
         uint64_t version;
-        file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
+        verifier >> version;
+        if (version != MEMPOOL_DUMP_VERSION_NO_SCRIPT_FLAGS && version != MEMPOOL_DUMP_VERSION) {
             return false;
         }
-        uint64_t num;
-        file >> num;
-        while (num) {
-            --num;
+        uint32_t policy_flags{0};
+        uint32_t consensus_flags{0};
+        if (version == MEMPOOL_DUMP_VERSION) {
+            verifier >> policy_flags >> consensus_flags;
+        }
+
+        // Read the whole file before accepting anything, so that the
+        // checksum can be verified first.
+        struct Entry {
             CTransactionRef tx;
             int64_t nTime;
             int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
+        };
+        std::vector<Entry> entries;
+        uint64_t num;
+        verifier >> num;
+        while (num) {
+            --num;
+            Entry& entry{entries.emplace_back()};
+            verifier >> entry.tx;
+            verifier >> entry.nTime;
+            verifier >> entry.nFeeDelta;
+            if (ShutdownRequested())
+                return false;
+        }
+        std::map<uint256, CAmount> mapDeltas;
+        verifier >> mapDeltas;
+        std::set<uint256> unbroadcast_txids;
+        verifier >> unbroadcast_txids;
+
+        // The scripts were checked when the transactions entered the mempool
+        // that was dumped, and the outputs a transaction spends are fixed by
+        // its inputs. So they only need to be checked again if the file is
+        // damaged, or if the flags changed since, e.g. because of a soft fork
+        // activation or an upgrade.
+        bool scripts_checked{false};
+        if (version == MEMPOOL_DUMP_VERSION) {
+            uint256 checksum;
+            file >> checksum;
+            scripts_checked = checksum == verifier.GetHash();
+            if (!scripts_checked) {
+                LogPrintf("Mempool file checksum mismatch, checking all transaction scripts.\n");
+            }
+        }
 
-            CAmount amountdelta = nFeeDelta;
+        for (const Entry& entry : entries) {
+            CAmount amountdelta = entry.nFeeDelta;
             if (amountdelta) {
-                pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+                pool.PrioritiseTransaction(entry.tx->GetHash(), amountdelta);
             }
-            if (nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
+            if (entry.nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
                 LOCK(cs_main);
-                const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, nTime, /*bypass_limits=*/false, /*test_accept=*/false);
+                const bool skip_script_checks{scripts_checked &&
+                                              policy_flags == STANDARD_SCRIPT_VERIFY_FLAGS &&
+                                              consensus_flags == GetMempoolScriptFlags(active_chainstate)};
+                const auto& accepted = AcceptToMemoryPool(active_chainstate, entry.tx, entry.nTime, /*bypass_limits=*/false, /*test_accept=*/false, skip_script_checks);
                 if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
                     ++count;
+                    if (skip_script_checks) ++unchecked;
                 } else {
                     // mempool may contain the transaction already, e.g. from
                     // wallet(s) having loaded it while we were processing
                     // mempool transactions; consider these as valid, instead of
                     // failed, but mark them as 'already there'
-                    if (pool.exists(GenTxid::Txid(tx->GetHash()))) {
+                    if (pool.exists(GenTxid::Txid(entry.tx->GetHash()))) {
                         ++already_there;
                     } else {
                         ++failed;
@@ -98,15 +146,11 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
             if (ShutdownRequested())
                 return false;
         }
-        std::map<uint256, CAmount> mapDeltas;
-        file >> mapDeltas;
 
         for (const auto& i : mapDeltas) {
             pool.PrioritiseTransaction(i.first, i.second);
         }
 
-        std::set<uint256> unbroadcast_txids;
-        file >> unbroadcast_txids;
         unbroadcast = unbroadcast_txids.size();
         for (const auto& txid : unbroadcast_txids) {
             // Ensure transactions were accepted to mempool then add to
@@ -118,28 +162,32 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
         return false;
     }
 
-    LogPrintf("Imported mempool transactions from disk: %i succeeded, %i failed, %i expired, %i already there, %i waiting for initial broadcast\n", count, failed, expired, already_there, unbroadcast);
+    LogPrintf("Imported mempool transactions from disk: %i succeeded (%i without script checks), %i failed, %i expired, %i already there, %i waiting for initial broadcast\n", count, unchecked, failed, expired, already_there, unbroadcast);
     return true;
 }
 
-bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path, FopenFn mockable_fopen_function, bool skip_file_commit)
+bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path, Chainstate& active_chainstate, FopenFn mockable_fopen_function, bool skip_file_commit)
 {
     auto start = SteadyClock::now();
 
     std::map<uint256, CAmount> mapDeltas;
     std::vector<TxMempoolInfo> vinfo;
     std::set<uint256> unbroadcast_txids;
+    uint32_t consensus_flags;
 
     static Mutex dump_mutex;
     LOCK(dump_mutex);
 
     {
-        LOCK(pool.cs);
+        // The flags must belong to the tip that the transactions were last
+        // checked against.
+        LOCK2(cs_main, pool.cs);
         for (const auto &i : pool.mapDeltas) {
             mapDeltas[i.first] = i.second;
         }
         vinfo = pool.infoAll();
         unbroadcast_txids = pool.GetUnbroadcastTxs();
+        consensus_flags = GetMempoolScriptFlags(active_chainstate);
     }
 
     auto mid = SteadyClock::now();
@@ -151,22 +199,27 @@ bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path, FopenFn mock
         }
 
         CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+        HashedSourceWriter<CAutoFile> writer{&file};
 
         uint64_t version = MEMPOOL_DUMP_VERSION;
-        file << version;
+        writer << version;
+        writer << uint32_t{STANDARD_SCRIPT_VERIFY_FLAGS};
+        writer << consensus_flags;
 
-        file << (uint64_t)vinfo.size();
+        writer << (uint64_t)vinfo.size();
         for (const auto& i : vinfo) {
-            file << *(i.tx);
-            file << int64_t{count_seconds(i.m_time)};
-            file << int64_t{i.nFeeDelta};
+            writer << *(i.tx);
+            writer << int64_t{count_seconds(i.m_time)};
+            writer << int64_t{i.nFeeDelta};
             mapDeltas.erase(i.tx->GetHash());
         }
 
-        file << mapDeltas;
+        writer << mapDeltas;
 
         LogPrintf("Writing %d unbroadcast transactions to disk.\n", unbroadcast_txids.size());
-        file << unbroadcast_txids;
+        writer << unbroadcast_txids;
+
+        file << writer.GetHash();
 
         if (!skip_file_commit && !FileCommit(file.Get()))
             throw std::runtime_error("FileCommit failed");
@@ -12,12 +12,17 @@ class CTxMemPool;
 
 namespace kernel {
 
-/** Dump the mempool to disk. */
+/** Dump the mempool to disk, together with the script verification flags of the active chainstate's tip. */
 bool DumpMempool(const CTxMemPool& pool, const fs::path& dump_path,
+                 Chainstate& active_chainstate,
                  fsbridge::FopenFn mockable_fopen_function = fsbridge::fopen,
                  bool skip_file_commit = false);
 
-/** Load the mempool from disk. */
+/**
+ * Load the mempool from disk. The scripts of the transactions are not
+ * checked again if the script verification flags are still the same as
+ * when the mempool was dumped.
+ */
 bool LoadMempool(CTxMemPool& pool, const fs::path& load_path,
                  Chainstate& active_chainstate,
                  fsbridge::FopenFn mockable_fopen_function = fsbridge::fopen);
@@ -5,6 +5,7 @@
 #ifndef BITCOIN_MEMUSAGE_H
 #define BITCOIN_MEMUSAGE_H
 
+#include <flathashmap.h>
 #include <indirectmap.h>
 #include <prevector.h>
 
@@ -166,6 +167,14 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+// FlatHashMap stores its elements inline, with one control byte per slot
+
+template<typename X, typename Y, typename Z, typename W>
+static inline size_t DynamicUsage(const FlatHashMap<X, Y, Z, W>& m)
+{
+    return MallocUsage(sizeof(std::pair<const X, Y>) * m.bucket_count()) + MallocUsage(m.bucket_count());
+}
+
 }
 
 #endif // BITCOIN_MEMUSAGE_H
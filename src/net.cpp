@@ -1240,11 +1240,11 @@ void CConnman::SocketHandler()
         const auto timeout = std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
 
         // Check for the readiness of the already connected sockets and the
-        // listening sockets in one call ("readiness" as in poll(2) or
-        // select(2)). If none are ready, wait for a short while and return
+        // listening sockets in one call ("readiness" as in epoll(7), poll(2)
+        // or select(2)). If none are ready, wait for a short while and return
         // empty sets.
         events_per_sock = GenerateWaitSockets(snap.Nodes());
-        if (events_per_sock.empty() || !events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
+        if (!m_wait_set.WaitMany(timeout, events_per_sock)) {
             interruptNet.sleep_for(timeout);
         }
 
@@ -1104,6 +1104,9 @@ private:
      */
     std::unique_ptr<i2p::sam::Session> m_i2p_sam_session;
 
+    /** Sockets waited on by the SocketHandler thread, kept registered across iterations. */
+    SockWaitSet m_wait_set; // Used only by SocketHandler thread
+
     std::thread threadDNSAddressSeed;
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
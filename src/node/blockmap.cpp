@@ -0,0 +1,36 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockmap.h>
+
+#include <cassert>
+
+namespace node {
+void BlockMap::Rehash(size_t slots)
+{
+    assert(slots > m_size && (slots & (slots - 1)) == 0);
+    m_table.assign(slots, EMPTY_SLOT);
+    for (size_t id = 0; id < m_size; ++id) {
+        m_table[FindSlot(Entry(id).first)] = id;
+    }
+}
+
+void BlockMap::reserve(size_t count)
+{
+    size_t slots{std::max<size_t>(m_table.size(), 2 * CHUNK_SIZE)};
+    while (slots < count * 2) slots *= 2;
+    if (slots != m_table.size()) Rehash(slots);
+    m_chunks.reserve((count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+void BlockMap::clear()
+{
+    for (size_t id = 0; id < m_size; ++id) {
+        Entry(id).~value_type();
+    }
+    m_chunks.clear();
+    m_table.clear();
+    m_size = 0;
+}
+} // namespace node
@@ -0,0 +1,184 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKMAP_H
+#define BITCOIN_NODE_BLOCKMAP_H
+
+#include <chain.h>
+#include <uint256.h>
+#include <util/hasher.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace node {
+/**
+ * Map from block hash to the CBlockIndex entry of every known header.
+ *
+ * Validation code keeps pointers to the entries, so they must never move.
+ * Instead of one heap node per entry, entries are constructed in place in
+ * large chunks that are only freed by clear(), and are numbered densely in
+ * insertion order. Lookups go through an open-addressing table of those
+ * numbers. This keeps headers that were added together (e.g. during header
+ * sync, or when loading the block index) next to each other in memory, and
+ * avoids the per-node allocation and fragmentation of std::unordered_map.
+ *
+ * Only the subset of the std::unordered_map interface that is needed is
+ * provided. Entries cannot be erased individually. Iteration visits entries
+ * in insertion order.
+ */
+class BlockMap
+{
+public:
+    using value_type = std::pair<const uint256, CBlockIndex>;
+
+private:
+    //! Number of entries per chunk
+    static constexpr size_t CHUNK_SIZE{1024};
+    //! Marks an unused slot in the hash table
+    static constexpr uint32_t EMPTY_SLOT{std::numeric_limits<uint32_t>::max()};
+
+    struct alignas(value_type) Storage {
+        std::byte bytes[sizeof(value_type)];
+    };
+
+    std::vector<std::unique_ptr<Storage[]>> m_chunks;
+    size_t m_size{0};
+    //! Entry numbers, indexed by block hash. The size is zero or a power of two.
+    std::vector<uint32_t> m_table;
+
+    value_type& Entry(size_t id) { return *std::launder(reinterpret_cast<value_type*>(&m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE])); }
+    const value_type& Entry(size_t id) const { return *std::launder(reinterpret_cast<const value_type*>(&m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE])); }
+
+    //! Table slot holding the entry for hash, or the empty slot where it belongs.
+    size_t FindSlot(const uint256& hash) const
+    {
+        const size_t mask{m_table.size() - 1};
+        for (size_t slot = BlockHasher{}(hash) & mask;; slot = (slot + 1) & mask) {
+            if (m_table[slot] == EMPTY_SLOT || Entry(m_table[slot]).first == hash) return slot;
+        }
+    }
+
+    //! Rebuild the hash table with the given number of slots.
+    void Rehash(size_t slots);
+
+    template <bool Const>
+    class Iterator
+    {
+        friend class BlockMap;
+        template <bool>
+        friend class Iterator;
+        using Map = std::conditional_t<Const, const BlockMap, BlockMap>;
+
+        Map* m_map{nullptr};
+        size_t m_id{0};
+
+        Iterator(Map* map, size_t id) : m_map{map}, m_id{id} {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = BlockMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        Iterator() = default;
+        //! Allow converting an iterator to a const_iterator.
+        template <bool C = Const, std::enable_if_t<C, int> = 0>
+        Iterator(const Iterator<false>& other) : m_map{other.m_map}, m_id{other.m_id} {}
+
+        reference operator*() const { return m_map->Entry(m_id); }
+        pointer operator->() const { return &m_map->Entry(m_id); }
+        Iterator& operator++()
+        {
+            ++m_id;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator copy{*this};
+            ++m_id;
+            return copy;
+        }
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_map == b.m_map && a.m_id == b.m_id; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return !(a == b); }
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    BlockMap() = default;
+    ~BlockMap() { clear(); }
+
+    BlockMap(const BlockMap&) = delete;
+    BlockMap& operator=(const BlockMap&) = delete;
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, m_size}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_size}; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    iterator find(const uint256& hash)
+    {
+        if (m_size == 0) return end();
+        const uint32_t id{m_table[FindSlot(hash)]};
+        return id == EMPTY_SLOT ? end() : iterator{this, id};
+    }
+    const_iterator find(const uint256& hash) const
+    {
+        if (m_size == 0) return end();
+        const uint32_t id{m_table[FindSlot(hash)]};
+        return id == EMPTY_SLOT ? end() : const_iterator{this, id};
+    }
+    size_t count(const uint256& hash) const { return find(hash) == end() ? 0 : 1; }
+
+    /**
+     * Construct a CBlockIndex for hash from args, unless there already is one.
+     *
+     * @returns the entry for hash, and whether it was inserted
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const uint256& hash, Args&&... args)
+    {
+        // Keep the table at most half full, so that probe sequences stay short.
+        if ((m_size + 1) * 2 > m_table.size()) {
+            Rehash(std::max<size_t>(m_table.size() * 2, 2 * CHUNK_SIZE));
+        }
+        const size_t slot{FindSlot(hash)};
+        if (m_table[slot] != EMPTY_SLOT) return {iterator{this, m_table[slot]}, false};
+
+        if (m_size == m_chunks.size() * CHUNK_SIZE) {
+            m_chunks.emplace_back(new Storage[CHUNK_SIZE]);
+        }
+        ::new (&m_chunks[m_size / CHUNK_SIZE][m_size % CHUNK_SIZE]) value_type(std::piecewise_construct,
+                                                                             std::forward_as_tuple(hash),
+                                                                             std::forward_as_tuple(std::forward<Args>(args)...));
+        m_table[slot] = m_size;
+        return {iterator{this, m_size++}, true};
+    }
+
+    CBlockIndex& operator[](const uint256& hash) { return try_emplace(hash).first->second; }
+
+    //! Prepare for holding count entries without rehashing.
+    void reserve(size_t count);
+
+    //! Destroy all entries, invalidating all pointers to them.
+    void clear();
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKMAP_H
@@ -17,10 +17,15 @@
 #include <signet.h>
 #include <streams.h>
 #include <undo.h>
+#include <util/mappedfile.h>
 #include <util/syscall_sandbox.h>
 #include <util/system.h>
+#include <util/time.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <unordered_map>
 
@@ -254,21 +259,255 @@ CBlockIndex* BlockManager::InsertBlockIndex(const uint256& hash)
     return pindex;
 }
 
-bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
+namespace {
+/** Magic bytes at the start of the block index snapshot file */
+constexpr uint8_t BLOCK_INDEX_SNAPSHOT_MAGIC[4]{'b', 'i', 'd', 'x'};
+constexpr uint32_t BLOCK_INDEX_SNAPSHOT_VERSION{1};
+/** Position of a missing pprev or pskip entry */
+constexpr uint32_t BLOCK_INDEX_SNAPSHOT_NONE{std::numeric_limits<uint32_t>::max()};
+
+/**
+ * One CBlockIndex in the block index snapshot file. Entries have a fixed size
+ * and are stored in order of height, referring to their pprev and pskip
+ * entries by position, so the file can be loaded straight from a memory
+ * mapping without hash lookups, sorting or recomputing the chain work.
+ */
+struct BlockIndexSnapshotEntry {
+    uint256 hash;
+    uint32_t prev{BLOCK_INDEX_SNAPSHOT_NONE};
+    uint32_t skip{BLOCK_INDEX_SNAPSHOT_NONE};
+    int32_t height{0};
+    int32_t file{0};
+    uint32_t data_pos{0};
+    uint32_t undo_pos{0};
+    uint32_t tx{0};
+    uint32_t status{0};
+    int32_t version{0};
+    uint256 merkle_root;
+    uint32_t time{0};
+    uint32_t bits{0};
+    uint32_t nonce{0};
+    uint32_t time_max{0};
+    uint256 chain_work;
+
+    SERIALIZE_METHODS(BlockIndexSnapshotEntry, obj)
+    {
+        READWRITE(obj.hash, obj.prev, obj.skip, obj.height, obj.file, obj.data_pos, obj.undo_pos, obj.tx, obj.status,
+                  obj.version, obj.merkle_root, obj.time, obj.bits, obj.nonce, obj.time_max, obj.chain_work);
+    }
+};
+constexpr size_t BLOCK_INDEX_SNAPSHOT_HEADER_SIZE{sizeof(BLOCK_INDEX_SNAPSHOT_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t)};
+constexpr size_t BLOCK_INDEX_SNAPSHOT_ENTRY_SIZE{3 * uint256::size() + 13 * sizeof(uint32_t)};
+
+fs::path BlockIndexSnapshotPath()
 {
-    if (!m_block_tree_db->LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); })) {
+    return gArgs.GetDataDirNet() / "blocks" / "blockindex.dat";
+}
+} // namespace
+
+bool BlockManager::LoadBlockIndexSnapshot(std::vector<CBlockIndex*>& sorted_by_height)
+{
+    AssertLockHeld(cs_main);
+
+    BlockIndexSnapshotInfo info;
+    if (!m_block_tree_db->ReadBlockIndexSnapshot(info)) {
+        return false;
+    }
+    // The database changes as soon as the node runs, so a snapshot is only
+    // ever good for the startup right after it was written.
+    if (!m_block_tree_db->EraseBlockIndexSnapshot()) {
+        return error("%s: failed to erase the block index snapshot record", __func__);
+    }
+    int last_block_file{0};
+    CBlockFileInfo last_block_file_info;
+    m_block_tree_db->ReadLastBlockFile(last_block_file);
+    m_block_tree_db->ReadBlockFileInfo(last_block_file, last_block_file_info);
+    if (last_block_file != info.last_block_file ||
+        last_block_file_info.nSize != info.last_block_file_size ||
+        last_block_file_info.nUndoSize != info.last_undo_file_size) {
+        LogPrintf("Block index snapshot does not match the block database, ignoring it\n");
         return false;
     }
 
-    // Calculate nChainWork
-    std::vector<CBlockIndex*> vSortedByHeight{GetAllBlockIndices()};
-    std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
-              CBlockIndexHeightOnlyComparator());
+    const auto time_start{SteadyClock::now()};
+    const fs::path path{BlockIndexSnapshotPath()};
+    MappedFile file{path};
+    if (file.IsNull()) {
+        LogPrintf("Unable to open block index snapshot %s, ignoring it\n", fs::PathToString(path));
+        return false;
+    }
+    HashWriter hasher{};
+    hasher.write(file.data());
+    if (hasher.GetHash() != info.hash) {
+        LogPrintf("Block index snapshot %s is corrupt, ignoring it\n", fs::PathToString(path));
+        return false;
+    }
+
+    try {
+        SpanReader reader{SER_DISK, CLIENT_VERSION, UCharSpanCast(file.data())};
+        uint8_t magic[sizeof(BLOCK_INDEX_SNAPSHOT_MAGIC)];
+        uint32_t version;
+        uint64_t count;
+        reader >> magic >> version >> count;
+        if (!std::equal(std::begin(magic), std::end(magic), std::begin(BLOCK_INDEX_SNAPSHOT_MAGIC)) ||
+            version != BLOCK_INDEX_SNAPSHOT_VERSION || reader.size() / BLOCK_INDEX_SNAPSHOT_ENTRY_SIZE != count ||
+            reader.size() % BLOCK_INDEX_SNAPSHOT_ENTRY_SIZE != 0) {
+            throw std::ios_base::failure("unknown format");
+        }
 
+        m_block_index.reserve(count);
+        sorted_by_height.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            BlockIndexSnapshotEntry entry;
+            reader >> entry;
+            // Entries only refer to earlier ones, which keeps the output sorted by height.
+            if ((entry.prev != BLOCK_INDEX_SNAPSHOT_NONE && entry.prev >= i) ||
+                (entry.skip != BLOCK_INDEX_SNAPSHOT_NONE && entry.skip >= i)) {
+                throw std::ios_base::failure("entry refers to a later one");
+            }
+            const auto [it, inserted]{m_block_index.try_emplace(entry.hash)};
+            if (!inserted) {
+                throw std::ios_base::failure("duplicate entry");
+            }
+            CBlockIndex* pindex{&it->second};
+            pindex->phashBlock = &it->first;
+            pindex->pprev = entry.prev == BLOCK_INDEX_SNAPSHOT_NONE ? nullptr : sorted_by_height[entry.prev];
+            pindex->pskip = entry.skip == BLOCK_INDEX_SNAPSHOT_NONE ? nullptr : sorted_by_height[entry.skip];
+            pindex->nHeight = entry.height;
+            pindex->nFile = entry.file;
+            pindex->nDataPos = entry.data_pos;
+            pindex->nUndoPos = entry.undo_pos;
+            pindex->nTx = entry.tx;
+            pindex->nStatus = entry.status;
+            pindex->nVersion = entry.version;
+            pindex->hashMerkleRoot = entry.merkle_root;
+            pindex->nTime = entry.time;
+            pindex->nBits = entry.bits;
+            pindex->nNonce = entry.nonce;
+            pindex->nTimeMax = entry.time_max;
+            pindex->nChainWork = UintToArith256(entry.chain_work);
+            sorted_by_height.push_back(pindex);
+        }
+    } catch (const std::ios_base::failure& e) {
+        LogPrintf("Unable to load block index snapshot %s: %s, ignoring it\n", fs::PathToString(path), e.what());
+        m_block_index.clear();
+        sorted_by_height.clear();
+        return false;
+    }
+
+    LogPrintf("Loaded %u block index entries from snapshot in %.2fms\n",
+              sorted_by_height.size(), Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+    return true;
+}
+
+bool BlockManager::WriteBlockIndexSnapshot()
+{
+    AssertLockHeld(::cs_main);
+    LOCK(cs_LastBlockFile);
+
+    if (m_block_index.empty()) {
+        return false;
+    }
+    if (!m_dirty_blockindex.empty() || !m_dirty_fileinfo.empty()) {
+        return error("%s: the block index has not been flushed", __func__);
+    }
+
+    const auto time_start{SteadyClock::now()};
+    std::vector<CBlockIndex*> sorted_by_height{GetAllBlockIndices()};
+    std::sort(sorted_by_height.begin(), sorted_by_height.end(), CBlockIndexHeightOnlyComparator());
+    std::unordered_map<const CBlockIndex*, uint32_t> positions;
+    positions.reserve(sorted_by_height.size());
+    for (const CBlockIndex* pindex : sorted_by_height) {
+        positions.emplace(pindex, positions.size());
+    }
+    const auto position{[&](const CBlockIndex* pindex) {
+        return pindex ? positions.at(pindex) : BLOCK_INDEX_SNAPSHOT_NONE;
+    }};
+
+    const fs::path path{BlockIndexSnapshotPath()};
+    BlockIndexSnapshotInfo info;
+    try {
+        FILE* filestr{fsbridge::fopen(path + ".new", "wb")};
+        if (!filestr) {
+            return error("%s: failed to open %s", __func__, fs::PathToString(path));
+        }
+        CAutoFile file{filestr, SER_DISK, CLIENT_VERSION};
+        HashWriter hasher{};
+        const auto write{[&](const auto& obj) {
+            file << obj;
+            hasher << obj;
+        }};
+
+        write(BLOCK_INDEX_SNAPSHOT_MAGIC);
+        write(BLOCK_INDEX_SNAPSHOT_VERSION);
+        write(uint64_t{sorted_by_height.size()});
+        for (const CBlockIndex* pindex : sorted_by_height) {
+            BlockIndexSnapshotEntry entry;
+            entry.hash = pindex->GetBlockHash();
+            entry.prev = position(pindex->pprev);
+            entry.skip = position(pindex->pskip);
+            entry.height = pindex->nHeight;
+            entry.file = pindex->nFile;
+            entry.data_pos = pindex->nDataPos;
+            entry.undo_pos = pindex->nUndoPos;
+            entry.tx = pindex->nTx;
+            entry.status = pindex->nStatus;
+            entry.version = pindex->nVersion;
+            entry.merkle_root = pindex->hashMerkleRoot;
+            entry.time = pindex->nTime;
+            entry.bits = pindex->nBits;
+            entry.nonce = pindex->nNonce;
+            entry.time_max = pindex->nTimeMax;
+            entry.chain_work = ArithToUint256(pindex->nChainWork);
+            write(entry);
+        }
+
+        if (!FileCommit(file.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        file.fclose();
+        if (!RenameOver(path + ".new", path)) {
+            throw std::runtime_error("Rename failed");
+        }
+        info.hash = hasher.GetHash();
+    } catch (const std::exception& e) {
+        return error("%s: failed to write %s: %s", __func__, fs::PathToString(path), e.what());
+    }
+
+    info.last_block_file = m_last_blockfile;
+    info.last_block_file_size = m_blockfile_info[m_last_blockfile].nSize;
+    info.last_undo_file_size = m_blockfile_info[m_last_blockfile].nUndoSize;
+    if (!m_block_tree_db->WriteBlockIndexSnapshot(info)) {
+        return error("%s: failed to record the block index snapshot", __func__);
+    }
+
+    LogPrintf("Wrote %u block index entries to snapshot in %.2fms\n",
+              sorted_by_height.size(), Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+    return true;
+}
+
+bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
+{
+    std::vector<CBlockIndex*> vSortedByHeight;
+    // Entries from the snapshot already carry their chain work, nTimeMax and pskip.
+    const bool from_snapshot{LoadBlockIndexSnapshot(vSortedByHeight)};
+    if (!from_snapshot) {
+        if (!m_block_tree_db->LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); })) {
+            return false;
+        }
+
+        vSortedByHeight = GetAllBlockIndices();
+        std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
+                  CBlockIndexHeightOnlyComparator());
+    }
+
+    // Calculate nChainWork
     for (CBlockIndex* pindex : vSortedByHeight) {
         if (ShutdownRequested()) return false;
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
-        pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
+        if (!from_snapshot) {
+            pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+            pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
+        }
 
         // We can link the chain of blocks for which we've received transactions at some point, or
         // blocks that are assumed-valid on the basis of snapshot load (see
@@ -290,7 +529,7 @@ bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
             pindex->nStatus |= BLOCK_FAILED_CHILD;
             m_dirty_blockindex.insert(pindex);
         }
-        if (pindex->pprev) {
+        if (pindex->pprev && !from_snapshot) {
             pindex->BuildSkip();
         }
     }
@@ -488,6 +727,11 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
         return error("%s: no undo data available", __func__);
     }
 
+    return UndoReadFromDisk(blockundo, pos, pindex->pprev->GetBlockHash());
+}
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& prev_block_hash)
+{
     // Open history file to read
     CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull()) {
@@ -498,7 +742,7 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
     uint256 hashChecksum;
     CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
     try {
-        verifier << pindex->pprev->GetBlockHash();
+        verifier << prev_block_hash;
         verifier >> blockundo;
         filein >> hashChecksum;
     } catch (const std::exception& e) {
@@ -11,6 +11,7 @@
 #include <net.h>
 #include <net_processing.h>
 #include <netgroup.h>
+#include <node/miner.h>
 #include <policy/fees.h>
 #include <scheduler.h>
 #include <txmempool.h>
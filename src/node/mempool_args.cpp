@@ -94,6 +94,8 @@ std::optional<bilingual_str> ApplyArgsManOptions(const ArgsManager& argsman, con
 
     mempool_opts.full_rbf = argsman.GetBoolArg("-mempoolfullrbf", mempool_opts.full_rbf);
 
+    mempool_opts.track_clusters = argsman.GetBoolArg("-mempoolclusters", mempool_opts.track_clusters);
+
     ApplyArgsManOptions(argsman, mempool_opts.limits);
 
     return std::nullopt;
@@ -24,6 +24,7 @@
 #include <validation.h>
 
 #include <algorithm>
+#include <queue>
 #include <utility>
 
 namespace node {
@@ -93,6 +94,7 @@ BlockAssembler::BlockAssembler(Chainstate& chainstate, const CTxMemPool* mempool
 void BlockAssembler::resetBlock()
 {
     inBlock.clear();
+    m_packages.clear();
 
     // Reserve space for coinbase tx
     nBlockWeight = 4000;
@@ -104,6 +106,12 @@ void BlockAssembler::resetBlock()
 }
 
 std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn)
+{
+    TemplateSelection selection;
+    return CreateNewBlock(scriptPubKeyIn, selection, {});
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, TemplateSelection& selection, const std::vector<CTransactionRef>& new_txs)
 {
     const auto time_start{SteadyClock::now()};
 
@@ -138,9 +146,20 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     int nPackagesSelected = 0;
     int nDescendantsUpdated = 0;
+    bool incremental = false;
+    const bool reuse_selection{selection.tip == pindexPrev};
+    // Only hand the selection back once the template passed validation
+    selection.tip = nullptr;
     if (m_mempool) {
         LOCK(m_mempool->cs);
-        addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+        if (reuse_selection && addSelectedTxs(*m_mempool, selection)) {
+            addNewTxs(*m_mempool, new_txs, nPackagesSelected);
+            incremental = true;
+        } else if (m_mempool->m_track_clusters) {
+            addChunkTxs(*m_mempool, nPackagesSelected);
+        } else {
+            addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+        }
     }
 
     const auto time_1{SteadyClock::now()};
@@ -175,8 +194,16 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     }
     const auto time_2{SteadyClock::now()};
 
-    LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n",
-             Ticks<MillisecondsDouble>(time_1 - time_start), nPackagesSelected, nDescendantsUpdated,
+    selection.txids.clear();
+    selection.txids.reserve(nBlockTx);
+    for (size_t i = 1; i < pblock->vtx.size(); ++i) {
+        selection.txids.push_back(pblock->vtx[i]->GetHash());
+    }
+    selection.packages = std::move(m_packages);
+    selection.tip = pindexPrev;
+
+    LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d %spackages, %d updated descendants), validity: %.2fms (total %.2fms)\n",
+             Ticks<MillisecondsDouble>(time_1 - time_start), nPackagesSelected, incremental ? "new " : "", nDescendantsUpdated,
              Ticks<MillisecondsDouble>(time_2 - time_1),
              Ticks<MillisecondsDouble>(time_2 - time_start));
 
@@ -417,11 +444,13 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
         std::vector<CTxMemPool::txiter> sortedEntries;
         SortForBlock(ancestors, sortedEntries);
 
+        const uint64_t weight_before{nBlockWeight};
         for (size_t i = 0; i < sortedEntries.size(); ++i) {
             AddToBlock(sortedEntries[i]);
             // Erase from the modified set, if present
             mapModifiedTx.erase(sortedEntries[i]);
         }
+        m_packages.push_back({sortedEntries.size(), packageSize, packageFees, packageSigOpsCost, nBlockWeight - weight_before});
 
         ++nPackagesSelected;
 
@@ -429,4 +458,238 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
         nDescendantsUpdated += UpdatePackagesForAdded(mempool, ancestors, mapModifiedTx);
     }
 }
+
+// With clusters, the mempool already knows in which order and groups its
+// transactions are best mined, so instead of updating ancestor feerates as
+// transactions get selected, the next chunk of every cluster is kept in a
+// heap, and the best one is added to the block.
+void BlockAssembler::addChunkTxs(const CTxMemPool& mempool, int& nPackagesSelected)
+{
+    AssertLockHeld(mempool.cs);
+
+    struct NextChunk {
+        const TxMempoolCluster* cluster;
+        size_t chunk;
+        //! Position of the first transaction of the chunk in cluster->txs
+        size_t start;
+    };
+    const auto lower_feerate{[](const NextChunk& a, const NextChunk& b) {
+        const TxMempoolCluster::Chunk& chunk_a{a.cluster->chunks[a.chunk]};
+        const TxMempoolCluster::Chunk& chunk_b{b.cluster->chunks[b.chunk]};
+        return double(chunk_a.fee) * chunk_b.size < double(chunk_b.fee) * chunk_a.size;
+    }};
+    std::priority_queue<NextChunk, std::vector<NextChunk>, decltype(lower_feerate)> queue{lower_feerate};
+    for (const TxMempoolCluster* cluster : mempool.GetClusters()) {
+        queue.push({cluster, 0, 0});
+    }
+
+    // Same heuristic as in addPackageTxs()
+    const int64_t MAX_CONSECUTIVE_FAILURES = 1000;
+    int64_t nConsecutiveFailed = 0;
+
+    while (!queue.empty()) {
+        const NextChunk next{queue.top()};
+        queue.pop();
+        const TxMempoolCluster::Chunk& chunk{next.cluster->chunks[next.chunk]};
+
+        if (chunk.fee < blockMinFeeRate.GetFee(chunk.size)) {
+            // Everything else we might consider has a lower fee rate
+            return;
+        }
+
+        CTxMemPool::setEntries entries;
+        int64_t sigops_cost{0};
+        for (size_t i = next.start; i < next.start + chunk.count; ++i) {
+            const CTxMemPool::txiter iter{mempool.mapTx.iterator_to(*next.cluster->txs[i])};
+            entries.insert(iter);
+            sigops_cost += iter->GetSigOpCost();
+        }
+
+        // Later chunks of the cluster may depend on this one, so if it cannot
+        // be added, the rest of the cluster is skipped.
+        if (!TestPackage(chunk.size, sigops_cost)) {
+            ++nConsecutiveFailed;
+            if (nConsecutiveFailed > MAX_CONSECUTIVE_FAILURES && nBlockWeight > nBlockMaxWeight - 4000) {
+                // Give up if we're close to full and haven't succeeded in a while
+                break;
+            }
+            continue;
+        }
+        if (!TestPackageTransactions(entries)) continue;
+
+        nConsecutiveFailed = 0;
+
+        const uint64_t weight_before{nBlockWeight};
+        for (size_t i = next.start; i < next.start + chunk.count; ++i) {
+            AddToBlock(mempool.mapTx.iterator_to(*next.cluster->txs[i]));
+        }
+        m_packages.push_back({chunk.count, uint64_t(chunk.size), chunk.fee, sigops_cost, nBlockWeight - weight_before});
+        ++nPackagesSelected;
+
+        if (next.chunk + 1 < next.cluster->chunks.size()) {
+            queue.push({next.cluster, next.chunk + 1, next.start + chunk.count});
+        }
+    }
+}
+
+bool BlockAssembler::addSelectedTxs(const CTxMemPool& mempool, const TemplateSelection& selection)
+{
+    AssertLockHeld(mempool.cs);
+
+    std::vector<CTxMemPool::txiter> entries;
+    entries.reserve(selection.txids.size());
+    auto txid{selection.txids.begin()};
+    for (const TemplateSelection::Package& package : selection.packages) {
+        CAmount mod_fees{0};
+        for (size_t i = 0; i < package.tx_count; ++i, ++txid) {
+            const auto iter{mempool.GetIter(*txid)};
+            if (!iter) return false;
+            mod_fees += (*iter)->GetModifiedFee();
+            entries.push_back(*iter);
+        }
+        // A changed fee delta could make a different selection better
+        if (mod_fees != package.mod_fees) return false;
+    }
+
+    // Nothing can have been added to the ancestors of selected transactions,
+    // and transactions leave the mempool together with their descendants, so
+    // the selection is still valid as a whole.
+    for (CTxMemPool::txiter iter : entries) {
+        AddToBlock(iter);
+    }
+    m_packages = selection.packages;
+    return true;
+}
+
+void BlockAssembler::RemoveLastPackage(const CTxMemPool& mempool)
+{
+    AssertLockHeld(mempool.cs);
+
+    CBlock& block{pblocktemplate->block};
+    for (size_t i = 0; i < m_packages.back().tx_count; ++i) {
+        const CTxMemPool::txiter iter{*Assert(mempool.GetIter(block.vtx.back()->GetHash()))};
+        nBlockWeight -= iter->GetTxWeight();
+        --nBlockTx;
+        nBlockSigOpsCost -= iter->GetSigOpCost();
+        nFees -= iter->GetFee();
+        inBlock.erase(iter);
+        block.vtx.pop_back();
+        pblocktemplate->vTxFees.pop_back();
+        pblocktemplate->vTxSigOpsCost.pop_back();
+    }
+    m_packages.pop_back();
+}
+
+void BlockAssembler::addNewTxs(const CTxMemPool& mempool, const std::vector<CTransactionRef>& txs, int& nPackagesSelected)
+{
+    AssertLockHeld(mempool.cs);
+
+    for (const CTransactionRef& tx : txs) {
+        // Skip transactions that left the mempool again, or that were already
+        // added as the ancestor of another one.
+        const auto iter{mempool.GetIter(tx->GetHash())};
+        if (!iter || inBlock.count(*iter)) continue;
+
+        CTxMemPool::setEntries ancestors;
+        std::string dummy;
+        mempool.CalculateMemPoolAncestors(**iter, ancestors, CTxMemPool::Limits::NoLimits(), dummy, false);
+        const CTxMemPool::setEntries all_ancestors{ancestors};
+
+        onlyUnconfirmed(ancestors);
+        ancestors.insert(*iter);
+
+        uint64_t packageSize{0};
+        CAmount packageFees{0};
+        int64_t packageSigOpsCost{0};
+        for (CTxMemPool::txiter it : ancestors) {
+            packageSize += it->GetTxSize();
+            packageFees += it->GetModifiedFee();
+            packageSigOpsCost += it->GetSigOpCost();
+        }
+        if (packageFees < blockMinFeeRate.GetFee(packageSize)) continue;
+        if (!TestPackageTransactions(ancestors)) continue;
+
+        // Nothing in the block depends on the packages at its end, so they can
+        // be dropped in favour of a package with a higher feerate, unless they
+        // contain ancestors of it.
+        size_t keep{m_packages.size()};
+        size_t block_end{pblocktemplate->block.vtx.size()};
+        uint64_t weight{nBlockWeight};
+        int64_t sigops_cost{static_cast<int64_t>(nBlockSigOpsCost)};
+        while (weight + WITNESS_SCALE_FACTOR * packageSize >= nBlockMaxWeight ||
+               sigops_cost + packageSigOpsCost >= MAX_BLOCK_SIGOPS_COST) {
+            if (keep == 0) break;
+            const TemplateSelection::Package& last{m_packages[keep - 1]};
+            if (double(last.mod_fees) * packageSize >= double(packageFees) * last.size) break;
+            bool has_ancestor{false};
+            for (size_t i = block_end - last.tx_count; i < block_end; ++i) {
+                has_ancestor |= all_ancestors.count(*Assert(mempool.GetIter(pblocktemplate->block.vtx[i]->GetHash()))) > 0;
+            }
+            if (has_ancestor) break;
+            weight -= last.weight;
+            sigops_cost -= last.sigops_cost;
+            block_end -= last.tx_count;
+            --keep;
+        }
+        if (weight + WITNESS_SCALE_FACTOR * packageSize >= nBlockMaxWeight ||
+            sigops_cost + packageSigOpsCost >= MAX_BLOCK_SIGOPS_COST) {
+            continue;
+        }
+
+        while (m_packages.size() > keep) {
+            RemoveLastPackage(mempool);
+        }
+
+        std::vector<CTxMemPool::txiter> sortedEntries;
+        SortForBlock(ancestors, sortedEntries);
+        const uint64_t weight_before{nBlockWeight};
+        for (CTxMemPool::txiter it : sortedEntries) {
+            AddToBlock(it);
+        }
+        m_packages.push_back({sortedEntries.size(), packageSize, packageFees, packageSigOpsCost, nBlockWeight - weight_before});
+        ++nPackagesSelected;
+    }
+}
+
+BlockTemplateCache::BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool, const BlockAssembler::Options& options)
+    : m_chainman{chainman},
+      m_mempool{mempool},
+      m_options{options}
+{
+}
+
+BlockTemplateCache::BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool)
+    : BlockTemplateCache(chainman, mempool, DefaultOptions()) {}
+
+std::unique_ptr<CBlockTemplate> BlockTemplateCache::CreateNewBlock(const CScript& scriptPubKeyIn)
+{
+    LOCK(::cs_main);
+    std::vector<CTransactionRef> new_txs;
+    {
+        LOCK(m_pending_mutex);
+        if (m_rebuild) m_selection.tip = nullptr;
+        m_rebuild = false;
+        new_txs.swap(m_pending_txs);
+    }
+    return BlockAssembler{m_chainman.ActiveChainstate(), &m_mempool, m_options}.CreateNewBlock(scriptPubKeyIn, m_selection, new_txs);
+}
+
+void BlockTemplateCache::Invalidate()
+{
+    LOCK(m_pending_mutex);
+    m_pending_txs.clear();
+    m_rebuild = true;
+}
+
+void BlockTemplateCache::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence)
+{
+    LOCK(m_pending_mutex);
+    if (m_rebuild) return;
+    if (m_pending_txs.size() >= MAX_PENDING_TXS) {
+        m_pending_txs.clear();
+        m_rebuild = true;
+        return;
+    }
+    m_pending_txs.push_back(tx);
+}
 } // namespace node
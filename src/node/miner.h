@@ -7,11 +7,14 @@
 #define BITCOIN_NODE_MINER_H
 
 #include <primitives/block.h>
+#include <sync.h>
 #include <txmempool.h>
+#include <validationinterface.h>
 
 #include <memory>
 #include <optional>
 #include <stdint.h>
+#include <vector>
 
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
@@ -124,6 +127,27 @@ struct update_for_parent_inclusion
     CTxMemPool::txiter iter;
 };
 
+/** Transactions selected for a block template, which a later template on the same tip can start from */
+struct TemplateSelection
+{
+    struct Package {
+        //! Number of transactions in the package, which are consecutive in the block
+        size_t tx_count;
+        //! Virtual size, modified fees and sigops cost of the package, as used when selecting it
+        uint64_t size;
+        CAmount mod_fees;
+        int64_t sigops_cost;
+        uint64_t weight;
+    };
+
+    //! Block the selection was made on top of, or nullptr if there is none
+    const CBlockIndex* tip{nullptr};
+    //! Txids of the selected transactions, in block order
+    std::vector<uint256> txids;
+    //! The packages the transactions were selected in, in block order
+    std::vector<Package> packages;
+};
+
 /** Generate a new block, without valid proof-of-work */
 class BlockAssembler
 {
@@ -141,6 +165,7 @@ private:
     uint64_t nBlockSigOpsCost;
     CAmount nFees;
     CTxMemPool::setEntries inBlock;
+    std::vector<TemplateSelection::Package> m_packages;
 
     // Chain context for the block
     int nHeight;
@@ -162,6 +187,15 @@ public:
 
     /** Construct a new block template with coinbase to scriptPubKeyIn */
     std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn);
+    /**
+     * Construct a new block template with coinbase to scriptPubKeyIn, starting
+     * from the transactions in selection if it was made on the current tip and
+     * all of them are still in the mempool with unchanged fees. new_txs are then
+     * considered for inclusion on top of it. Otherwise, transactions are
+     * selected from scratch. On success, selection is updated to the returned
+     * template.
+     */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, TemplateSelection& selection, const std::vector<CTransactionRef>& new_txs);
 
     inline static std::optional<int64_t> m_last_block_num_txs{};
     inline static std::optional<int64_t> m_last_block_weight{};
@@ -178,6 +212,20 @@ private:
       * Increments nPackagesSelected / nDescendantsUpdated with corresponding
       * statistics from the package selection (for logging statistics). */
     void addPackageTxs(const CTxMemPool& mempool, int& nPackagesSelected, int& nDescendantsUpdated) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Add transactions chunk by chunk, merging the linearizations of the
+      * mempool's clusters by chunk feerate. Requires a mempool that tracks
+      * clusters. */
+    void addChunkTxs(const CTxMemPool& mempool, int& nPackagesSelected) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Add the transactions of an earlier selection. Returns false without
+      * changing the block if any of them left the mempool, or the fees of a
+      * package changed. */
+    bool addSelectedTxs(const CTxMemPool& mempool, const TemplateSelection& selection) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Add each of txs together with its ancestors that are not in the block yet,
+      * making room by removing packages with a lower feerate from the end of the
+      * block if necessary. */
+    void addNewTxs(const CTxMemPool& mempool, const std::vector<CTransactionRef>& txs, int& nPackagesSelected) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Remove the most recently added package from the block */
+    void RemoveLastPackage(const CTxMemPool& mempool) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 
     // helper functions for addPackageTxs()
     /** Remove confirmed (inBlock) entries from given set */
@@ -193,6 +241,45 @@ private:
     void SortForBlock(const CTxMemPool::setEntries& package, std::vector<CTxMemPool::txiter>& sortedEntries);
 };
 
+/**
+ * Keeps the transaction selection of the last block template, so that the
+ * next one only has to revisit transactions that entered the mempool since.
+ *
+ * Transactions are picked up through the validation interface. A template is
+ * built from scratch when the tip changed, when a selected transaction left
+ * the mempool or had its fee changed, and after Invalidate().
+ */
+class BlockTemplateCache final : public CValidationInterface
+{
+    //! Number of queued transactions after which a fresh selection is cheaper
+    static constexpr size_t MAX_PENDING_TXS{10000};
+
+    ChainstateManager& m_chainman;
+    const CTxMemPool& m_mempool;
+    const BlockAssembler::Options m_options;
+
+    TemplateSelection m_selection GUARDED_BY(::cs_main);
+
+    Mutex m_pending_mutex;
+    //! Transactions added to the mempool since the last template
+    std::vector<CTransactionRef> m_pending_txs GUARDED_BY(m_pending_mutex);
+    //! Whether the next template must be built from scratch
+    bool m_rebuild GUARDED_BY(m_pending_mutex){false};
+
+public:
+    BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool);
+    BlockTemplateCache(ChainstateManager& chainman, const CTxMemPool& mempool, const BlockAssembler::Options& options);
+
+    /** Construct a new block template with coinbase to scriptPubKeyIn */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn) EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
+    /** Build the next template from scratch, e.g. because fee deltas changed */
+    void Invalidate() EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) override EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+};
+
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
 
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
@@ -4,7 +4,10 @@
 
 #include <node/utxo_snapshot.h>
 
+#include <clientversion.h>
+#include <crypto/sha256.h>
 #include <fs.h>
+#include <kernel/coinstats.h>
 #include <logging.h>
 #include <streams.h>
 #include <uint256.h>
@@ -12,10 +15,72 @@
 #include <validation.h>
 
 #include <cstdio>
+#include <limits>
 #include <optional>
 
 namespace node {
 
+static uint256 HashSnapshotChunk(Span<const unsigned char> data)
+{
+    uint256 hash;
+    CSHA256().Write(data.data(), data.size()).Finalize(hash.begin());
+    return hash;
+}
+
+SnapshotChunk SerializeSnapshotChunk(const std::vector<std::pair<COutPoint, Coin>>& coins)
+{
+    SnapshotChunk chunk;
+    CVectorWriter writer{SER_DISK, CLIENT_VERSION, chunk.data, 0};
+    for (const auto& [outpoint, coin] : coins) {
+        writer << outpoint << coin;
+    }
+    chunk.header.m_coins_count = coins.size();
+    chunk.header.m_size = chunk.data.size();
+    chunk.header.m_hash = HashSnapshotChunk(chunk.data);
+    return chunk;
+}
+
+std::optional<SnapshotChunkCoins> ParseSnapshotChunk(const SnapshotChunkHeader& header, Span<const unsigned char> data, int base_height)
+{
+    if (data.size() != header.m_size || HashSnapshotChunk(data) != header.m_hash) {
+        LogPrintf("[snapshot] snapshot chunk does not match its hash\n");
+        return std::nullopt;
+    }
+
+    SnapshotChunkCoins chunk;
+    CVectorWriter hash_writer{SER_GETHASH, 0, chunk.hash_data, 0};
+    SpanReader reader{SER_DISK, CLIENT_VERSION, data};
+    std::optional<COutPoint> prev_outpoint;
+    try {
+        for (uint32_t i = 0; i < header.m_coins_count; ++i) {
+            COutPoint outpoint;
+            Coin coin;
+            reader >> outpoint >> coin;
+            if (coin.nHeight > base_height || coin.IsSpent() ||
+                outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() || // Avoid integer wrap-around in coinstats.cpp:ApplyHash
+                (prev_outpoint && !(*prev_outpoint < outpoint))) {
+                LogPrintf("[snapshot] bad coin in snapshot chunk\n");
+                return std::nullopt;
+            }
+            prev_outpoint = outpoint;
+            if (chunk.txs.empty() || chunk.txs.back().first != outpoint.hash) {
+                if (!chunk.txs.empty()) kernel::TxOutputsHashSer(hash_writer, chunk.txs.back().first, chunk.txs.back().second);
+                chunk.txs.emplace_back(outpoint.hash, std::map<uint32_t, Coin>{});
+            }
+            chunk.txs.back().second.emplace(outpoint.n, std::move(coin));
+        }
+    } catch (const std::ios_base::failure&) {
+        LogPrintf("[snapshot] bad snapshot chunk format\n");
+        return std::nullopt;
+    }
+    if (!reader.empty()) {
+        LogPrintf("[snapshot] unexpected data after the coins in snapshot chunk\n");
+        return std::nullopt;
+    }
+    if (!chunk.txs.empty()) kernel::TxOutputsHashSer(hash_writer, chunk.txs.back().first, chunk.txs.back().second);
+    return chunk;
+}
+
 bool WriteSnapshotBaseBlockhash(Chainstate& snapshot_chainstate)
 {
     AssertLockHeld(::cs_main);
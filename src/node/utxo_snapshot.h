@@ -6,18 +6,42 @@
 #ifndef BITCOIN_NODE_UTXO_SNAPSHOT_H
 #define BITCOIN_NODE_UTXO_SNAPSHOT_H
 
+#include <coins.h>
 #include <fs.h>
 #include <uint256.h>
 #include <serialize.h>
+#include <span.h>
+#include <tinyformat.h>
 #include <validation.h>
 
+#include <ios>
+#include <map>
 #include <optional>
+#include <utility>
+#include <vector>
 
 extern RecursiveMutex cs_main;
 
 namespace node {
+//! Version of the UTXO snapshot format.
+static constexpr uint16_t SNAPSHOT_VERSION{2};
+
+//! Number of coins after which a snapshot chunk is closed.
+static constexpr uint32_t SNAPSHOT_CHUNK_COINS{100000};
+//! Approximate size after which a snapshot chunk is closed.
+static constexpr uint64_t SNAPSHOT_CHUNK_TARGET_SIZE{16 << 20};
+//! Largest snapshot chunk accepted when loading a snapshot. Chunks only end
+//! after a whole transaction, so they can exceed the target size by the
+//! unspent outputs of one transaction.
+static constexpr uint32_t MAX_SNAPSHOT_CHUNK_SIZE{32 << 20};
+//! Maximum number of threads serializing and checking snapshot chunks.
+static constexpr int MAX_SNAPSHOT_THREADS{16};
+
 //! Metadata describing a serialized version of a UTXO set from which an
 //! assumeutxo Chainstate can be constructed.
+//!
+//! In a snapshot file the metadata is followed by chunks of coins, each
+//! starting with a SnapshotChunkHeader.
 class SnapshotMetadata
 {
 public:
@@ -37,9 +61,68 @@ public:
             m_base_blockhash(base_blockhash),
             m_coins_count(coins_count) { }
 
-    SERIALIZE_METHODS(SnapshotMetadata, obj) { READWRITE(obj.m_base_blockhash, obj.m_coins_count); }
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << SNAPSHOT_VERSION << m_base_blockhash << m_coins_count;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        uint16_t version;
+        s >> version;
+        if (version != SNAPSHOT_VERSION) {
+            throw std::ios_base::failure(strprintf("Unsupported snapshot version %u", version));
+        }
+        s >> m_base_blockhash >> m_coins_count;
+    }
+};
+
+//! Header of a chunk of coins in a UTXO snapshot.
+//!
+//! A chunk holds all unspent outputs of one or more transactions, in the
+//! order of the coins database, as COutPoint and Coin pairs. The header
+//! commits to the serialized coins, so every chunk can be checked and
+//! deserialized independently. As it gives the size of the chunk, chunks can
+//! be located without reading them, for example in a memory mapped file.
+class SnapshotChunkHeader
+{
+public:
+    //! The number of coins in the chunk.
+    uint32_t m_coins_count{0};
+    //! The size of the serialized coins.
+    uint32_t m_size{0};
+    //! SHA256 of the serialized coins.
+    uint256 m_hash;
+
+    SERIALIZE_METHODS(SnapshotChunkHeader, obj) { READWRITE(obj.m_coins_count, obj.m_size, obj.m_hash); }
+};
+
+//! A serialized chunk of coins, ready to be written to a snapshot.
+struct SnapshotChunk {
+    SnapshotChunkHeader header;
+    std::vector<unsigned char> data;
 };
 
+//! Serialize coins, sorted as in the coins database, into a snapshot chunk.
+SnapshotChunk SerializeSnapshotChunk(const std::vector<std::pair<COutPoint, Coin>>& coins);
+
+//! The coins of a snapshot chunk, checked and ready to be loaded.
+struct SnapshotChunkCoins {
+    //! The unspent outputs in the chunk, grouped by transaction.
+    std::vector<std::pair<uint256, std::map<uint32_t, Coin>>> txs;
+    //! The data the chunk adds to the HASH_SERIALIZED hash of the UTXO set.
+    std::vector<unsigned char> hash_data;
+};
+
+//! Deserialize and check a snapshot chunk.
+//!
+//! @returns nullopt if the data does not match the header, cannot be
+//!          deserialized, is not sorted or contains coins that are spent or
+//!          from after base_height.
+std::optional<SnapshotChunkCoins> ParseSnapshotChunk(const SnapshotChunkHeader& header, Span<const unsigned char> data, int base_height);
+
 //! The file in the snapshot chainstate dir which stores the base blockhash. This is
 //! needed to reconstruct snapshot chainstates on init.
 //!
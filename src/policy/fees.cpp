@@ -28,10 +28,14 @@
 #include <cstddef>
 #include <cstdint>
 #include <exception>
+#include <iterator>
+#include <optional>
 #include <stdexcept>
 #include <utility>
 
 static constexpr double INF_FEERATE = 1e99;
+/** Scale of the moving averages below which they are rescaled, see TxConfirmStats::m_avg_scale */
+static constexpr double MIN_AVG_SCALE = 1e-20;
 
 std::string StringForFeeEstimateHorizon(FeeEstimateHorizon horizon)
 {
@@ -109,8 +113,26 @@ private:
     // transactions still unconfirmed after GetMaxConfirms for each bucket
     std::vector<int> oldUnconfTxs;
 
+    // The moving averages above are decayed lazily, so that a block does not
+    // have to update each of them: their actual values are the stored values
+    // times m_avg_scale, which is multiplied by decay instead.
+    double m_avg_scale{1};
+
+    // Number of transactions counted as unconfirmed for each confirmation
+    // target and bucket, computed from unconfTxs and oldUnconfTxs on first use
+    // for a block height. Reset when the counters change.
+    mutable std::vector<std::vector<int>> m_unconf_counts; // m_unconf_counts[Y][X]
+    mutable std::optional<unsigned int> m_unconf_counts_height;
+
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Multiply the stored moving averages by m_avg_scale and reset it */
+    void ApplyAvgScale();
+
+    /** Return the number of transactions in each bucket that have been
+     * unconfirmed for confTarget blocks or longer */
+    const std::vector<int>& GetUnconfirmedCounts(unsigned int confTarget, unsigned int nBlockHeight) const;
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -152,10 +174,11 @@ public:
      * @param sufficientTxVal required average number of transactions per block in a bucket range
      * @param minSuccess the success probability we require
      * @param nBlockHeight the current block height
+     * @param log whether to log the calculation
      */
     double EstimateMedianVal(int confTarget, double sufficientTxVal,
                              double minSuccess, unsigned int nBlockHeight,
-                             EstimationResult *result = nullptr) const;
+                             EstimationResult *result = nullptr, bool log = true) const;
 
     /** Return the max number of confirms we're tracking */
     unsigned int GetMaxConfirms() const { return scale * confAvg.size(); }
@@ -197,6 +220,37 @@ void TxConfirmStats::resizeInMemoryCounters(size_t newbuckets) {
         unconfTxs[i].resize(newbuckets);
     }
     oldUnconfTxs.resize(newbuckets);
+    m_unconf_counts_height.reset();
+}
+
+void TxConfirmStats::ApplyAvgScale()
+{
+    for (unsigned int j = 0; j < buckets.size(); j++) {
+        for (unsigned int i = 0; i < confAvg.size(); i++) {
+            confAvg[i][j] *= m_avg_scale;
+            failAvg[i][j] *= m_avg_scale;
+        }
+        m_feerate_avg[j] *= m_avg_scale;
+        txCtAvg[j] *= m_avg_scale;
+    }
+    m_avg_scale = 1;
+}
+
+const std::vector<int>& TxConfirmStats::GetUnconfirmedCounts(unsigned int confTarget, unsigned int nBlockHeight) const
+{
+    if (m_unconf_counts_height != nBlockHeight) {
+        // Sum the transactions unconfirmed for each number of blocks, from
+        // the oldest ones down
+        const unsigned int bins = unconfTxs.size();
+        m_unconf_counts.assign(GetMaxConfirms() + 1, oldUnconfTxs);
+        for (unsigned int confct = GetMaxConfirms(); confct-- > 0;) {
+            for (unsigned int j = 0; j < oldUnconfTxs.size(); j++) {
+                m_unconf_counts[confct][j] = m_unconf_counts[confct + 1][j] + unconfTxs[(nBlockHeight - confct) % bins][j];
+            }
+        }
+        m_unconf_counts_height = nBlockHeight;
+    }
+    return m_unconf_counts[std::min(confTarget, GetMaxConfirms())];
 }
 
 // Roll the unconfirmed txs circular buffer
@@ -206,6 +260,7 @@ void TxConfirmStats::ClearCurrent(unsigned int nBlockHeight)
         oldUnconfTxs[j] += unconfTxs[nBlockHeight % unconfTxs.size()][j];
         unconfTxs[nBlockHeight%unconfTxs.size()][j] = 0;
     }
+    m_unconf_counts_height.reset();
 }
 
 
@@ -216,30 +271,26 @@ void TxConfirmStats::Record(int blocksToConfirm, double feerate)
         return;
     int periodsToConfirm = (blocksToConfirm + scale - 1) / scale;
     unsigned int bucketindex = bucketMap.lower_bound(feerate)->second;
+    const double weight = 1 / m_avg_scale;
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += weight;
     }
-    txCtAvg[bucketindex]++;
-    m_feerate_avg[bucketindex] += feerate;
+    txCtAvg[bucketindex] += weight;
+    m_feerate_avg[bucketindex] += feerate * weight;
 }
 
 void TxConfirmStats::UpdateMovingAverages()
 {
     assert(confAvg.size() == failAvg.size());
-    for (unsigned int j = 0; j < buckets.size(); j++) {
-        for (unsigned int i = 0; i < confAvg.size(); i++) {
-            confAvg[i][j] *= decay;
-            failAvg[i][j] *= decay;
-        }
-        m_feerate_avg[j] *= decay;
-        txCtAvg[j] *= decay;
-    }
+    m_avg_scale *= decay;
+    // Keep the stored values well within the range of a double
+    if (m_avg_scale < MIN_AVG_SCALE) ApplyAvgScale();
 }
 
 // returns -1 on error conditions
 double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
                                          double successBreakPoint, unsigned int nBlockHeight,
-                                         EstimationResult *result) const
+                                         EstimationResult *result, bool log) const
 {
     // Counters for a bucket (or range of buckets)
     double nConf = 0; // Number of tx's confirmed within the confTarget
@@ -248,6 +299,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     double failNum = 0; // Number of tx's that were never confirmed but removed from the mempool after confTarget
     const int periodTarget = (confTarget + scale - 1) / scale;
     const int maxbucketindex = buckets.size() - 1;
+    const std::vector<int>& unconfCounts = GetUnconfirmedCounts(confTarget, nBlockHeight);
 
     // We'll combine buckets until we have enough samples.
     // The near and far variables will define the range we've combined
@@ -260,7 +312,6 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     unsigned int bestFarBucket = maxbucketindex;
 
     bool foundAnswer = false;
-    unsigned int bins = unconfTxs.size();
     bool newBucketRange = true;
     bool passing = true;
     EstimatorBucket passBucket;
@@ -273,12 +324,10 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
-        for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
-            extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
-        extraNum += oldUnconfTxs[bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * m_avg_scale;
+        totalNum += txCtAvg[bucket] * m_avg_scale;
+        failNum += failAvg[periodTarget - 1][bucket] * m_avg_scale;
+        extraNum += unconfCounts[bucket];
         // If we have enough transaction data points in this range of buckets,
         // we can test for success
         // (Only count the confirmed data points, so that each confirmation count
@@ -371,7 +420,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
         failed_within_target_perc = 100 * failBucket.withinTarget / (failBucket.totalConfirmed + failBucket.inMempool + failBucket.leftMempool);
     }
 
-    LogPrint(BCLog::ESTIMATEFEE, "FeeEst: %d > %.0f%% decay %.5f: feerate: %g from (%g - %g) %.2f%% %.1f/(%.1f %d mem %.1f out) Fail: (%g - %g) %.2f%% %.1f/(%.1f %d mem %.1f out)\n",
+    if (log) LogPrint(BCLog::ESTIMATEFEE, "FeeEst: %d > %.0f%% decay %.5f: feerate: %g from (%g - %g) %.2f%% %.1f/(%.1f %d mem %.1f out) Fail: (%g - %g) %.2f%% %.1f/(%.1f %d mem %.1f out)\n",
              confTarget, 100.0 * successBreakPoint, decay,
              median, passBucket.start, passBucket.end,
              passed_within_target_perc,
@@ -392,12 +441,21 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
 
 void TxConfirmStats::Write(AutoFile& fileout) const
 {
+    // Write the actual values of the moving averages
+    const auto apply_scale = [this](std::vector<double> avg) {
+        for (double& val : avg) val *= m_avg_scale;
+        return avg;
+    };
+    std::vector<std::vector<double>> conf_avg, fail_avg;
+    std::transform(confAvg.begin(), confAvg.end(), std::back_inserter(conf_avg), apply_scale);
+    std::transform(failAvg.begin(), failAvg.end(), std::back_inserter(fail_avg), apply_scale);
+
     fileout << Using<EncodedDoubleFormatter>(decay);
     fileout << scale;
-    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(m_feerate_avg);
-    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(txCtAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(confAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(failAvg);
+    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(apply_scale(m_feerate_avg));
+    fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(apply_scale(txCtAvg));
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(conf_avg);
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(fail_avg);
 }
 
 void TxConfirmStats::Read(AutoFile& filein, int nFileVersion, size_t numBuckets)
@@ -461,6 +519,7 @@ unsigned int TxConfirmStats::NewTx(unsigned int nBlockHeight, double val)
     unsigned int bucketindex = bucketMap.lower_bound(val)->second;
     unsigned int blockIndex = nBlockHeight % unconfTxs.size();
     unconfTxs[blockIndex][bucketindex]++;
+    m_unconf_counts_height.reset();
     return bucketindex;
 }
 
@@ -475,6 +534,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         return;  //This can't happen because we call this with our best seen height, no entries can have higher
     }
 
+    m_unconf_counts_height.reset();
     if (blocksAgo >= (int)unconfTxs.size()) {
         if (oldUnconfTxs[bucketindex] > 0) {
             oldUnconfTxs[bucketindex]--;
@@ -496,7 +556,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += 1 / m_avg_scale;
         }
     }
 }
@@ -550,6 +610,7 @@ CBlockPolicyEstimator::CBlockPolicyEstimator(const fs::path& estimation_filepath
     if (est_file.IsNull() || !Read(est_file)) {
         LogPrintf("Failed to read fee estimates from %s. Continue anyway.\n", fs::PathToString(m_estimation_filepath));
     }
+    WITH_LOCK(m_cs_fee_estimator, UpdateSmartFeeEstimates());
 }
 
 CBlockPolicyEstimator::~CBlockPolicyEstimator() = default;
@@ -668,6 +729,8 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
 
     trackedTxs = 0;
     untrackedTxs = 0;
+
+    UpdateSmartFeeEstimates();
 }
 
 CFeeRate CBlockPolicyEstimator::estimateFee(int confTarget) const
@@ -766,26 +829,26 @@ double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, doubl
     if (confTarget >= 1 && confTarget <= longStats->GetMaxConfirms()) {
         // Find estimate from shortest time horizon possible
         if (confTarget <= shortStats->GetMaxConfirms()) { // short horizon
-            estimate = shortStats->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, result);
+            estimate = shortStats->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, result, /*log=*/false);
         }
         else if (confTarget <= feeStats->GetMaxConfirms()) { // medium horizon
-            estimate = feeStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
+            estimate = feeStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result, /*log=*/false);
         }
         else { // long horizon
-            estimate = longStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
+            estimate = longStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result, /*log=*/false);
         }
         if (checkShorterHorizon) {
             EstimationResult tempResult;
             // If a lower confTarget from a more recent horizon returns a lower answer use it.
             if (confTarget > feeStats->GetMaxConfirms()) {
-                double medMax = feeStats->EstimateMedianVal(feeStats->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, &tempResult);
+                double medMax = feeStats->EstimateMedianVal(feeStats->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, &tempResult, /*log=*/false);
                 if (medMax > 0 && (estimate == -1 || medMax < estimate)) {
                     estimate = medMax;
                     if (result) *result = tempResult;
                 }
             }
             if (confTarget > shortStats->GetMaxConfirms()) {
-                double shortMax = shortStats->EstimateMedianVal(shortStats->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, &tempResult);
+                double shortMax = shortStats->EstimateMedianVal(shortStats->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, &tempResult, /*log=*/false);
                 if (shortMax > 0 && (estimate == -1 || shortMax < estimate)) {
                     estimate = shortMax;
                     if (result) *result = tempResult;
@@ -804,10 +867,10 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
     double estimate = -1;
     EstimationResult tempResult;
     if (doubleTarget <= shortStats->GetMaxConfirms()) {
-        estimate = feeStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, result);
+        estimate = feeStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, result, /*log=*/false);
     }
     if (doubleTarget <= feeStats->GetMaxConfirms()) {
-        double longEstimate = longStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, &tempResult);
+        double longEstimate = longStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, &tempResult, /*log=*/false);
         if (longEstimate > estimate) {
             estimate = longEstimate;
             if (result) *result = tempResult;
@@ -825,33 +888,44 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
  */
 CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
 {
-    LOCK(m_cs_fee_estimator);
+    const std::shared_ptr<const SmartFeeEstimates> estimates = WITH_LOCK(m_smart_fee_mutex, return m_smart_fee_estimates);
 
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
     }
 
-    double median = -1;
-    EstimationResult tempResult;
-
     // Return failure if trying to analyze a target we're not tracking
-    if (confTarget <= 0 || (unsigned int)confTarget > longStats->GetMaxConfirms()) {
+    if (confTarget <= 0 || (unsigned int)confTarget > estimates->max_target) {
         return CFeeRate(0);  // error condition
     }
 
     // It's not possible to get reasonable estimates for confTarget of 1
     if (confTarget == 1) confTarget = 2;
 
-    unsigned int maxUsableEstimate = MaxUsableEstimate();
-    if ((unsigned int)confTarget > maxUsableEstimate) {
-        confTarget = maxUsableEstimate;
+    if ((unsigned int)confTarget > estimates->max_usable_target) {
+        confTarget = estimates->max_usable_target;
     }
     if (feeCalc) feeCalc->returnedTarget = confTarget;
 
     if (confTarget <= 1) return CFeeRate(0); // error condition
 
-    assert(confTarget > 0); //estimateCombinedFee and estimateConservativeFee take unsigned ints
+    const auto& [feerate, calc] = estimates->results[conservative][confTarget];
+    if (feeCalc) {
+        feeCalc->est = calc.est;
+        feeCalc->reason = calc.reason;
+    }
+    return feerate;
+}
+
+CFeeRate CBlockPolicyEstimator::ComputeSmartFee(unsigned int confTarget, FeeCalculation& feeCalc, bool conservative) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
+    assert(confTarget > 1);
+
+    double median = -1;
+    EstimationResult tempResult;
+
     /** true is passed to estimateCombined fee for target/2 and target so
      * that we check the max confirms for shorter time horizons as well.
      * This is necessary to preserve monotonically increasing estimates.
@@ -863,36 +937,28 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
      * fluctuations lower our estimates by too much.
      */
     double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, &tempResult);
-    if (feeCalc) {
-        feeCalc->est = tempResult;
-        feeCalc->reason = FeeReason::HALF_ESTIMATE;
-    }
+    feeCalc.est = tempResult;
+    feeCalc.reason = FeeReason::HALF_ESTIMATE;
     median = halfEst;
     double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, &tempResult);
     if (actualEst > median) {
         median = actualEst;
-        if (feeCalc) {
-            feeCalc->est = tempResult;
-            feeCalc->reason = FeeReason::FULL_ESTIMATE;
-        }
+        feeCalc.est = tempResult;
+        feeCalc.reason = FeeReason::FULL_ESTIMATE;
     }
     double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult);
     if (doubleEst > median) {
         median = doubleEst;
-        if (feeCalc) {
-            feeCalc->est = tempResult;
-            feeCalc->reason = FeeReason::DOUBLE_ESTIMATE;
-        }
+        feeCalc.est = tempResult;
+        feeCalc.reason = FeeReason::DOUBLE_ESTIMATE;
     }
 
     if (conservative || median == -1) {
         double consEst =  estimateConservativeFee(2 * confTarget, &tempResult);
         if (consEst > median) {
             median = consEst;
-            if (feeCalc) {
-                feeCalc->est = tempResult;
-                feeCalc->reason = FeeReason::CONSERVATIVE;
-            }
+            feeCalc.est = tempResult;
+            feeCalc.reason = FeeReason::CONSERVATIVE;
         }
     }
 
@@ -901,6 +967,29 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
     return CFeeRate(llround(median));
 }
 
+void CBlockPolicyEstimator::UpdateSmartFeeEstimates()
+{
+    AssertLockHeld(m_cs_fee_estimator);
+    const auto start{SteadyClock::now()};
+
+    auto estimates = std::make_shared<SmartFeeEstimates>();
+    estimates->max_target = longStats->GetMaxConfirms();
+    estimates->max_usable_target = MaxUsableEstimate();
+    for (const bool conservative : {false, true}) {
+        auto& results = estimates->results[conservative];
+        results.resize(estimates->max_usable_target + 1);
+        // Estimates are never given for a target below 2
+        for (unsigned int target = 2; target <= estimates->max_usable_target; ++target) {
+            auto& [feerate, calc] = results[target];
+            feerate = ComputeSmartFee(target, calc, conservative);
+        }
+    }
+    WITH_LOCK(m_smart_fee_mutex, m_smart_fee_estimates = std::move(estimates));
+
+    LogPrint(BCLog::ESTIMATEFEE, "Blockpolicy smart fee estimates updated for targets up to %u in %.2fms\n",
+             MaxUsableEstimate(), Ticks<MillisecondsDouble>(SteadyClock::now() - start));
+}
+
 void CBlockPolicyEstimator::Flush() {
     FlushUnconfirmed();
 
@@ -988,6 +1077,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            UpdateSmartFeeEstimates();
         }
     }
     catch (const std::exception& e) {
@@ -1007,6 +1097,7 @@ void CBlockPolicyEstimator::FlushUnconfirmed()
         auto mi = mapMemPoolTxs.begin();
         _removeTx(mi->first, false); // this calls erase() on mapMemPoolTxs
     }
+    UpdateSmartFeeEstimates();
     const auto endclear{SteadyClock::now()};
     LogPrint(BCLog::ESTIMATEFEE, "Recorded %u unconfirmed txs from mempool in %gs\n", num_entries, Ticks<SecondsDouble>(endclear - startclear));
 }
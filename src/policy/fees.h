@@ -18,6 +18,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 class AutoFile;
@@ -189,7 +190,7 @@ public:
     /** Process all the transactions that have been included in a block */
     void processBlock(unsigned int nBlockHeight,
                       std::vector<const CTxMemPoolEntry*>& entries)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator, !m_smart_fee_mutex);
 
     /** Process a transaction accepted to the mempool*/
     void processTransaction(const CTxMemPoolEntry& entry, bool validFeeEstimate)
@@ -207,9 +208,14 @@ public:
      *  blocks. If no answer can be given at confTarget, return an estimate at
      *  the closest target where one can be given.  'conservative' estimates are
      *  valid over longer time horizons also.
+     *
+     *  The estimates for all targets are computed when a block is processed,
+     *  so this does not wait for m_cs_fee_estimator. Transactions that leave
+     *  the mempool without being mined are only taken into account from the
+     *  next block on.
      */
     CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
-        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_smart_fee_mutex);
 
     /** Return a specific fee estimate calculation with a given success
      * threshold and time horizon, and optionally return detailed data about
@@ -225,11 +231,11 @@ public:
 
     /** Read estimation data from a file */
     bool Read(AutoFile& filein)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator, !m_smart_fee_mutex);
 
     /** Empty mempool transactions on shutdown to record failure to confirm for txs still in mempool */
     void FlushUnconfirmed()
-        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator, !m_smart_fee_mutex);
 
     /** Calculation of highest target that estimates are tracked for */
     unsigned int HighestTargetTracked(FeeEstimateHorizon horizon) const
@@ -237,7 +243,7 @@ public:
 
     /** Drop still unconfirmed transactions and record current estimations, if the fee estimation file is present. */
     void Flush()
-        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator, !m_smart_fee_mutex);
 
 private:
     mutable Mutex m_cs_fee_estimator;
@@ -271,6 +277,25 @@ private:
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry) EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
 
+    /** Results of estimateSmartFee, for every target it can return */
+    struct SmartFeeEstimates
+    {
+        //! Highest target that estimates are tracked for
+        unsigned int max_target{0};
+        //! Highest target that an estimate can be given for
+        unsigned int max_usable_target{0};
+        //! Economical and conservative results, indexed by target
+        std::array<std::vector<std::pair<CFeeRate, FeeCalculation>>, 2> results;
+    };
+
+    mutable Mutex m_smart_fee_mutex;
+    std::shared_ptr<const SmartFeeEstimates> m_smart_fee_estimates GUARDED_BY(m_smart_fee_mutex);
+
+    /** Calculate the result of estimateSmartFee for a target that can be returned */
+    CFeeRate ComputeSmartFee(unsigned int confTarget, FeeCalculation& feeCalc, bool conservative) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    /** Recompute m_smart_fee_estimates from the current stats */
+    void UpdateSmartFeeEstimates() EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator, !m_smart_fee_mutex);
+
     /** Helper for estimateSmartFee */
     double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
@@ -155,6 +155,26 @@ std::optional<std::string> PaysMoreThanConflicts(const CTxMemPool::setEntries& i
     return std::nullopt;
 }
 
+std::optional<std::string> PaysMoreThanConflictChunks(const CTxMemPool& pool,
+                                                      const CTxMemPool::setEntries& iters_conflicting,
+                                                      CFeeRate replacement_feerate,
+                                                      const uint256& txid)
+{
+    AssertLockHeld(pool.cs);
+    for (const auto& mi : iters_conflicting) {
+        // Unlike the feerate of the transaction alone, the feerate of its chunk accounts for the
+        // descendants that a miner would include with it, and the ancestors it has to wait for.
+        const CFeeRate original_feerate{pool.GetChunkFeeRate(mi)};
+        if (replacement_feerate <= original_feerate) {
+            return strprintf("rejecting replacement %s; new feerate %s <= old chunk feerate %s",
+                             txid.ToString(),
+                             replacement_feerate.ToString(),
+                             original_feerate.ToString());
+        }
+    }
+    return std::nullopt;
+}
+
 std::optional<std::string> PaysForRBF(CAmount original_fees,
                                       CAmount replacement_fees,
                                       size_t replacement_vsize,
@@ -91,6 +91,18 @@ std::optional<std::string> EntriesAndTxidsDisjoint(const CTxMemPool::setEntries&
 std::optional<std::string> PaysMoreThanConflicts(const CTxMemPool::setEntries& iters_conflicting,
                                                  CFeeRate replacement_feerate, const uint256& txid);
 
+/** Check that the feerate of the replacement transaction(s) is higher than the feerate of the
+ * chunk each of the transactions in iters_conflicting belongs to, i.e. the feerate it would be
+ * mined at. Used instead of PaysMoreThanConflicts() when the mempool tracks clusters.
+ * @param[in]   pool               The mempool, which must track clusters.
+ * @param[in]   iters_conflicting  The set of mempool entries.
+ * @returns error message if fees insufficient, otherwise std::nullopt.
+ */
+std::optional<std::string> PaysMoreThanConflictChunks(const CTxMemPool& pool,
+                                                      const CTxMemPool::setEntries& iters_conflicting,
+                                                      CFeeRate replacement_feerate, const uint256& txid)
+    EXCLUSIVE_LOCKS_REQUIRED(pool.cs);
+
 /** The replacement transaction must pay more fees than the original transactions. The additional
  * fees must pay for the replacement's bandwidth at or above the incremental relay feerate.
  * @param[in]   original_fees       Total modified fees of original transaction(s).
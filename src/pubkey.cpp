@@ -211,6 +211,22 @@ bool XOnlyPubKey::VerifySchnorr(const uint256& msg, Span<const unsigned char> si
     return secp256k1_schnorrsig_verify(secp256k1_context_verify, sigbytes.data(), msg.begin(), 32, &pubkey);
 }
 
+void SchnorrSignatureBatch::Add(const XOnlyPubKey& pubkey, const uint256& msg, Span<const unsigned char> sigbytes)
+{
+    assert(sigbytes.size() == 64);
+    Entry& entry{m_entries.emplace_back(Entry{pubkey, msg, {}})};
+    std::copy(sigbytes.begin(), sigbytes.end(), entry.sig.begin());
+}
+
+bool SchnorrSignatureBatch::Verify() const
+{
+    // The bundled libsecp256k1 has no batch verification API yet, so the
+    // signatures are checked one at a time.
+    return std::all_of(m_entries.begin(), m_entries.end(), [](const Entry& entry) {
+        return entry.pubkey.VerifySchnorr(entry.msg, entry.sig);
+    });
+}
+
 static const HashWriter HASHER_TAPTWEAK{TaggedHash("TapTweak")};
 
 uint256 XOnlyPubKey::ComputeTapTweakHash(const uint256* merkle_root) const
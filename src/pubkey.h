@@ -12,6 +12,7 @@
 #include <span.h>
 #include <uint256.h>
 
+#include <array>
 #include <cstring>
 #include <optional>
 #include <vector>
@@ -291,6 +292,31 @@ public:
     SERIALIZE_METHODS(XOnlyPubKey, obj) { READWRITE(obj.m_keydata); }
 };
 
+/** A set of BIP340 signatures that are verified together. */
+class SchnorrSignatureBatch
+{
+private:
+    struct Entry {
+        XOnlyPubKey pubkey;
+        uint256 msg;
+        std::array<unsigned char, 64> sig;
+    };
+    std::vector<Entry> m_entries;
+
+public:
+    /** Add a signature to be verified. sigbytes must be 64 bytes. */
+    void Add(const XOnlyPubKey& pubkey, const uint256& msg, Span<const unsigned char> sigbytes);
+
+    /** Verify all signatures added since the last clear().
+     *
+     * @returns false if any of them is invalid.
+     */
+    bool Verify() const;
+
+    size_t size() const { return m_entries.size(); }
+    void clear() { m_entries.clear(); }
+};
+
 struct CExtPubKey {
     unsigned char version[4];
     unsigned char nDepth;
@@ -26,6 +26,7 @@
 #include <txmempool.h>
 #include <util/check.h>
 #include <util/system.h>
+#include <util/time.h>
 #include <validation.h>
 #include <version.h>
 
@@ -40,6 +41,8 @@ using node::ReadBlockFromDisk;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
+//! Number of mempool entries written per chunk of /rest/mempool/contents
+static constexpr size_t REST_MEMPOOL_BATCH_SIZE = 1000;
 
 static const struct {
     RESTResponseFormat rf;
@@ -632,6 +635,31 @@ static bool rest_deploymentinfo(const std::any& context, HTTPRequest* req, const
 
 }
 
+/**
+ * Write the mempool entries as a sequence of (transaction, entry time in
+ * seconds, fee, modified fee), with parents before their children. Like
+ * MempoolToJSONStream, the mempool lock is only held per batch of entries.
+ */
+static void MempoolToBinaryStream(const CTxMemPool& pool, size_t batch_size, HTTPRequest* req)
+{
+    std::vector<uint256> txids;
+    pool.queryHashes(txids);
+
+    for (size_t begin = 0; begin < txids.size(); begin += batch_size) {
+        const size_t end{std::min(begin + batch_size, txids.size())};
+        CDataStream ssEntries(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+        {
+            LOCK(pool.cs);
+            for (size_t i = begin; i < end; ++i) {
+                const auto it{pool.mapTx.find(txids[i])};
+                if (it == pool.mapTx.end()) continue;
+                ssEntries << it->GetTx() << int64_t{count_seconds(it->GetTime())} << it->GetFee() << it->GetModifiedFee();
+            }
+        }
+        req->WriteReplyChunk(ssEntries.str());
+    }
+}
+
 static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
 {
     if (!CheckWarmup(req))
@@ -647,20 +675,36 @@ static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::s
     if (!mempool) return false;
 
     switch (rf) {
+    case RESTResponseFormat::BINARY: {
+        if (param != "contents") {
+            return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+        }
+
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReplyStart(HTTP_OK);
+        MempoolToBinaryStream(*mempool, REST_MEMPOOL_BATCH_SIZE, req);
+        req->WriteReplyEnd();
+        return true;
+    }
     case RESTResponseFormat::JSON: {
-        std::string str_json;
         if (param == "contents") {
-            str_json = MempoolToJSON(*mempool, true).write() + "\n";
-        } else {
-            str_json = MempoolInfoToJSON(*mempool).write() + "\n";
+            // Stream the contents, instead of building them all in memory
+            // while holding the mempool lock
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReplyStart(HTTP_OK);
+            MempoolToJSONStream(*mempool, REST_MEMPOOL_BATCH_SIZE, [req](std::string&& chunk) {
+                req->WriteReplyChunk(std::move(chunk));
+            });
+            req->WriteReplyEnd();
+            return true;
         }
 
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, str_json);
+        req->WriteReply(HTTP_OK, MempoolInfoToJSON(*mempool).write() + "\n");
         return true;
     }
     default: {
-        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+        return RESTERR(req, HTTP_NOT_FOUND, std::string{"output format not found (available: "} + (param == "contents" ? "bin, json" : "json") + ")");
     }
     }
 }
@@ -39,7 +39,9 @@
 #include <univalue.h>
 #include <util/check.h>
 #include <util/strencodings.h>
+#include <util/syscall_sandbox.h>
 #include <util/system.h>
+#include <util/threadpool.h>
 #include <util/translation.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -48,7 +50,10 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <condition_variable>
+#include <deque>
+#include <future>
 #include <memory>
 #include <mutex>
 
@@ -58,6 +63,7 @@ using kernel::CoinStatsHashType;
 using node::BlockManager;
 using node::NodeContext;
 using node::ReadBlockFromDisk;
+using node::SnapshotChunk;
 using node::SnapshotMetadata;
 using node::UndoReadFromDisk;
 
@@ -2548,7 +2554,8 @@ UniValue CreateUTXOSnapshot(
     Chainstate& chainstate,
     AutoFile& afile,
     const fs::path& path,
-    const fs::path& temppath)
+    const fs::path& temppath,
+    uint32_t chunk_coins)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor;
     std::optional<CCoinsStats> maybe_stats;
@@ -2588,20 +2595,53 @@ UniValue CreateUTXOSnapshot(
 
     afile << metadata;
 
-    COutPoint key;
-    Coin coin;
-    unsigned int iter{0};
+    // Chunks are serialized and hashed by the worker threads, and written in
+    // order as they complete.
+    const int threads_num{std::clamp(GetNumCores(), 1, node::MAX_SNAPSHOT_THREADS)};
+    ThreadPool pool{"snapshot"};
+    pool.Start(threads_num, SyscallSandboxPolicy::VALIDATION_SNAPSHOT);
+    std::deque<std::future<SnapshotChunk>> pending_chunks;
+    const auto write_chunk{[&] {
+        const SnapshotChunk chunk{pending_chunks.front().get()};
+        pending_chunks.pop_front();
+        afile << chunk.header;
+        afile.write(MakeByteSpan(chunk.data));
+    }};
+
+    try {
+        std::vector<std::pair<COutPoint, Coin>> coins;
+        uint64_t chunk_size{0};
+        COutPoint key;
+        Coin coin;
+        unsigned int iter{0};
+
+        while (pcursor->Valid()) {
+            if (iter % 5000 == 0) node.rpc_interruption_point();
+            ++iter;
+            if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
+                // Only close a chunk between transactions.
+                if (!coins.empty() && key.hash != coins.back().first.hash &&
+                    (coins.size() >= chunk_coins || chunk_size >= node::SNAPSHOT_CHUNK_TARGET_SIZE)) {
+                    pending_chunks.push_back(pool.Submit([coins = std::move(coins)] { return node::SerializeSnapshotChunk(coins); }));
+                    coins.clear();
+                    chunk_size = 0;
+                    if (pending_chunks.size() > size_t(2 * threads_num)) write_chunk();
+                }
+                chunk_size += kernel::GetBogoSize(coin.out.scriptPubKey);
+                coins.emplace_back(key, std::move(coin));
+            }
 
-    while (pcursor->Valid()) {
-        if (iter % 5000 == 0) node.rpc_interruption_point();
-        ++iter;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            afile << key;
-            afile << coin;
+            pcursor->Next();
         }
-
-        pcursor->Next();
+        if (!coins.empty()) {
+            pending_chunks.push_back(pool.Submit([coins = std::move(coins)] { return node::SerializeSnapshotChunk(coins); }));
+        }
+        while (!pending_chunks.empty()) write_chunk();
+    } catch (...) {
+        pool.Stop();
+        throw;
     }
+    pool.Stop();
 
     afile.fclose();
 
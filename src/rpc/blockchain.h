@@ -8,6 +8,7 @@
 #include <consensus/amount.h>
 #include <core_io.h>
 #include <fs.h>
+#include <node/utxo_snapshot.h>
 #include <streams.h>
 #include <sync.h>
 #include <validation.h>
@@ -50,6 +51,7 @@ void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES],
 
 /**
  * Helper to create UTXO snapshots given a chainstate and a file handle.
+ * @param chunk_coins the number of coins after which a chunk is closed.
  * @return a UniValue map containing metadata about the snapshot.
  */
 UniValue CreateUTXOSnapshot(
@@ -57,6 +59,7 @@ UniValue CreateUTXOSnapshot(
     Chainstate& chainstate,
     AutoFile& afile,
     const fs::path& path,
-    const fs::path& tmppath);
+    const fs::path& tmppath,
+    uint32_t chunk_coins = node::SNAPSHOT_CHUNK_COINS);
 
 #endif // BITCOIN_RPC_BLOCKCHAIN_H
@@ -21,6 +21,7 @@
 #include <univalue.h>
 #include <util/moneystr.h>
 #include <util/time.h>
+#include <util/vector.h>
 
 using kernel::DumpMempool;
 
@@ -337,6 +338,13 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
             o.__pushKV(hash.ToString(), info);
         }
         return o;
+    } else if (!include_mempool_sequence) {
+        // Read the snapshot, so that this does not wait for the mempool lock
+        UniValue a(UniValue::VARR);
+        for (const TxMempoolInfo& info : pool.GetSnapshot().GetAll()) {
+            a.push_back(info.tx->GetHash().ToString());
+        }
+        return a;
     } else {
         uint64_t mempool_sequence;
         std::vector<uint256> vtxid;
@@ -349,15 +357,40 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
         for (const uint256& hash : vtxid)
             a.push_back(hash.ToString());
 
-        if (!include_mempool_sequence) {
-            return a;
-        } else {
-            UniValue o(UniValue::VOBJ);
-            o.pushKV("txids", a);
-            o.pushKV("mempool_sequence", mempool_sequence);
-            return o;
+        UniValue o(UniValue::VOBJ);
+        o.pushKV("txids", a);
+        o.pushKV("mempool_sequence", mempool_sequence);
+        return o;
+    }
+}
+
+void MempoolToJSONStream(const CTxMemPool& pool, size_t batch_size, const std::function<void(std::string&&)>& write)
+{
+    assert(batch_size > 0);
+    std::vector<uint256> txids;
+    pool.queryHashes(txids);
+
+    std::string out{"{"};
+    bool first{true};
+    for (size_t begin = 0; begin < txids.size(); begin += batch_size) {
+        const size_t end{std::min(begin + batch_size, txids.size())};
+        {
+            LOCK(pool.cs);
+            for (size_t i = begin; i < end; ++i) {
+                const auto it{pool.mapTx.find(txids[i])};
+                if (it == pool.mapTx.end()) continue;
+                UniValue info(UniValue::VOBJ);
+                entryToJSON(pool, info, *it);
+                if (!first) out += ',';
+                first = false;
+                out += '"' + txids[i].ToString() + "\":" + info.write();
+            }
         }
+        write(std::move(out));
+        out.clear();
     }
+    out += "}\n";
+    write(std::move(out));
 }
 
 static RPCHelpMan getrawmempool()
@@ -721,6 +754,7 @@ static RPCHelpMan savemempool()
 {
     const ArgsManager& args{EnsureAnyArgsman(request.context)};
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
 
     if (!mempool.GetLoadTried()) {
         throw JSONRPCError(RPC_MISC_ERROR, "The mempool was not loaded yet");
@@ -728,7 +762,7 @@ static RPCHelpMan savemempool()
 
     const fs::path& dump_path = MempoolPath(args);
 
-    if (!DumpMempool(mempool, dump_path)) {
+    if (!DumpMempool(mempool, dump_path, chainman.ActiveChainstate())) {
         throw JSONRPCError(RPC_MISC_ERROR, "Unable to dump mempool to disk");
     }
 
@@ -740,6 +774,92 @@ static RPCHelpMan savemempool()
     };
 }
 
+/** Maximum number of packages accepted by a single submitpackages call, which holds cs_main throughout. */
+static constexpr size_t MAX_SUBMIT_PACKAGES{1000};
+
+static std::vector<RPCResult> PackageResultDoc()
+{
+    return {
+        {RPCResult::Type::OBJ_DYN, "tx-results", "transaction results keyed by wtxid",
+        {
+            {RPCResult::Type::OBJ, "wtxid", "transaction wtxid", {
+                {RPCResult::Type::STR_HEX, "txid", "The transaction hash in hex"},
+                {RPCResult::Type::STR_HEX, "other-wtxid", /*optional=*/true, "The wtxid of a different transaction with the same txid but different witness found in the mempool. This means the submitted transaction was ignored."},
+                {RPCResult::Type::NUM, "vsize", /*optional=*/true, "Virtual transaction size as defined in BIP 141."},
+                {RPCResult::Type::OBJ, "fees", /*optional=*/true, "Transaction fees", {
+                    {RPCResult::Type::STR_AMOUNT, "base", "transaction fee in " + CURRENCY_UNIT},
+                }},
+                {RPCResult::Type::STR, "error", /*optional=*/true, "The transaction validation error, if the transaction was rejected"},
+            }}
+        }},
+        {RPCResult::Type::STR_AMOUNT, "package-feerate", /*optional=*/true, "package feerate used for feerate checks in " + CURRENCY_UNIT + " per KvB. Excludes transactions which were deduplicated or accepted individually."},
+        {RPCResult::Type::ARR, "replaced-transactions", /*optional=*/true, "List of txids of replaced transactions",
+        {
+            {RPCResult::Type::STR_HEX, "", "The transaction id"},
+        }},
+    };
+}
+
+static UniValue PackageResultToJSON(const Package& txns, const PackageMempoolAcceptResult& package_result)
+{
+    UniValue rpc_result{UniValue::VOBJ};
+    UniValue tx_result_map{UniValue::VOBJ};
+    std::set<uint256> replaced_txids;
+    for (const auto& tx : txns) {
+        auto it = package_result.m_tx_results.find(tx->GetWitnessHash());
+        // Validation may have stopped before reaching this transaction.
+        if (it == package_result.m_tx_results.end()) continue;
+        UniValue result_inner{UniValue::VOBJ};
+        result_inner.pushKV("txid", tx->GetHash().GetHex());
+        if (it->second.m_result_type == MempoolAcceptResult::ResultType::DIFFERENT_WITNESS) {
+            result_inner.pushKV("other-wtxid", it->second.m_other_wtxid.value().GetHex());
+        }
+        if (it->second.m_result_type == MempoolAcceptResult::ResultType::VALID ||
+            it->second.m_result_type == MempoolAcceptResult::ResultType::MEMPOOL_ENTRY) {
+            result_inner.pushKV("vsize", int64_t{it->second.m_vsize.value()});
+            UniValue fees(UniValue::VOBJ);
+            fees.pushKV("base", ValueFromAmount(it->second.m_base_fees.value()));
+            result_inner.pushKV("fees", fees);
+            if (it->second.m_replaced_transactions.has_value()) {
+                for (const auto& ptx : it->second.m_replaced_transactions.value()) {
+                    replaced_txids.insert(ptx->GetHash());
+                }
+            }
+        } else if (it->second.m_result_type == MempoolAcceptResult::ResultType::INVALID) {
+            result_inner.pushKV("error", it->second.m_state.GetRejectReason());
+        }
+        tx_result_map.pushKV(tx->GetWitnessHash().GetHex(), result_inner);
+    }
+    rpc_result.pushKV("tx-results", tx_result_map);
+    if (package_result.m_package_feerate.has_value()) {
+        rpc_result.pushKV("package-feerate", ValueFromAmount(package_result.m_package_feerate.value().GetFeePerK()));
+    }
+    UniValue replaced_list(UniValue::VARR);
+    for (const uint256& hash : replaced_txids) replaced_list.push_back(hash.ToString());
+    rpc_result.pushKV("replaced-transactions", replaced_list);
+    return rpc_result;
+}
+
+static Package DecodePackage(const UniValue& raw_transactions)
+{
+    if (raw_transactions.size() < 1 || raw_transactions.size() > MAX_PACKAGE_COUNT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER,
+                           "Array must contain between 1 and " + ToString(MAX_PACKAGE_COUNT) + " transactions.");
+    }
+
+    Package txns;
+    txns.reserve(raw_transactions.size());
+    for (const auto& rawtx : raw_transactions.getValues()) {
+        CMutableTransaction mtx;
+        if (!DecodeHexTx(mtx, rawtx.get_str())) {
+            throw JSONRPCError(RPC_DESERIALIZATION_ERROR,
+                               "TX decode failed: " + rawtx.get_str() + " Make sure the tx has at least one input.");
+        }
+        txns.emplace_back(MakeTransactionRef(std::move(mtx)));
+    }
+    return txns;
+}
+
 static RPCHelpMan submitpackage()
 {
     return RPCHelpMan{"submitpackage",
@@ -757,25 +877,7 @@ static RPCHelpMan submitpackage()
             },
         },
         RPCResult{
-            RPCResult::Type::OBJ, "", "",
-            {
-                {RPCResult::Type::OBJ_DYN, "tx-results", "transaction results keyed by wtxid",
-                {
-                    {RPCResult::Type::OBJ, "wtxid", "transaction wtxid", {
-                        {RPCResult::Type::STR_HEX, "txid", "The transaction hash in hex"},
-                        {RPCResult::Type::STR_HEX, "other-wtxid", /*optional=*/true, "The wtxid of a different transaction with the same txid but different witness found in the mempool. This means the submitted transaction was ignored."},
-                        {RPCResult::Type::NUM, "vsize", "Virtual transaction size as defined in BIP 141."},
-                        {RPCResult::Type::OBJ, "fees", "Transaction fees", {
-                            {RPCResult::Type::STR_AMOUNT, "base", "transaction fee in " + CURRENCY_UNIT},
-                        }},
-                    }}
-                }},
-                {RPCResult::Type::STR_AMOUNT, "package-feerate", /*optional=*/true, "package feerate used for feerate checks in " + CURRENCY_UNIT + " per KvB. Excludes transactions which were deduplicated or accepted individually."},
-                {RPCResult::Type::ARR, "replaced-transactions", /*optional=*/true, "List of txids of replaced transactions",
-                {
-                    {RPCResult::Type::STR_HEX, "", "The transaction id"},
-                }},
-            },
+            RPCResult::Type::OBJ, "", "", PackageResultDoc(),
         },
         RPCExamples{
             HelpExampleCli("testmempoolaccept", "[rawtx1, rawtx2]") +
@@ -789,22 +891,7 @@ static RPCHelpMan submitpackage()
             RPCTypeCheck(request.params, {
                 UniValue::VARR,
             });
-            const UniValue raw_transactions = request.params[0].get_array();
-            if (raw_transactions.size() < 1 || raw_transactions.size() > MAX_PACKAGE_COUNT) {
-                throw JSONRPCError(RPC_INVALID_PARAMETER,
-                                   "Array must contain between 1 and " + ToString(MAX_PACKAGE_COUNT) + " transactions.");
-            }
-
-            std::vector<CTransactionRef> txns;
-            txns.reserve(raw_transactions.size());
-            for (const auto& rawtx : raw_transactions.getValues()) {
-                CMutableTransaction mtx;
-                if (!DecodeHexTx(mtx, rawtx.get_str())) {
-                    throw JSONRPCError(RPC_DESERIALIZATION_ERROR,
-                                       "TX decode failed: " + rawtx.get_str() + " Make sure the tx has at least one input.");
-                }
-                txns.emplace_back(MakeTransactionRef(std::move(mtx)));
-            }
+            const Package txns{DecodePackage(request.params[0].get_array())};
 
             NodeContext& node = EnsureAnyNodeContext(request.context);
             CTxMemPool& mempool = EnsureMemPool(node);
@@ -847,38 +934,99 @@ static RPCHelpMan submitpackage()
                             err_string, num_submitted));
                 }
             }
-            UniValue rpc_result{UniValue::VOBJ};
-            UniValue tx_result_map{UniValue::VOBJ};
-            std::set<uint256> replaced_txids;
             for (const auto& tx : txns) {
-                auto it = package_result.m_tx_results.find(tx->GetWitnessHash());
-                CHECK_NONFATAL(it != package_result.m_tx_results.end());
-                UniValue result_inner{UniValue::VOBJ};
-                result_inner.pushKV("txid", tx->GetHash().GetHex());
-                if (it->second.m_result_type == MempoolAcceptResult::ResultType::DIFFERENT_WITNESS) {
-                    result_inner.pushKV("other-wtxid", it->second.m_other_wtxid.value().GetHex());
-                }
-                if (it->second.m_result_type == MempoolAcceptResult::ResultType::VALID ||
-                    it->second.m_result_type == MempoolAcceptResult::ResultType::MEMPOOL_ENTRY) {
-                    result_inner.pushKV("vsize", int64_t{it->second.m_vsize.value()});
-                    UniValue fees(UniValue::VOBJ);
-                    fees.pushKV("base", ValueFromAmount(it->second.m_base_fees.value()));
-                    result_inner.pushKV("fees", fees);
-                    if (it->second.m_replaced_transactions.has_value()) {
-                        for (const auto& ptx : it->second.m_replaced_transactions.value()) {
-                            replaced_txids.insert(ptx->GetHash());
-                        }
+                CHECK_NONFATAL(package_result.m_tx_results.count(tx->GetWitnessHash()));
+            }
+            return PackageResultToJSON(txns, package_result);
+        },
+    };
+}
+
+static RPCHelpMan submitpackages()
+{
+    return RPCHelpMan{"submitpackages",
+        "Submit a batch of packages of raw transactions (serialized, hex-encoded) to local node (-regtest only).\n"
+        "Each package is validated as in submitpackage, in the given order, and a later package may spend outputs of an earlier one.\n"
+        "Unlike submitpackage, a package that fails validation does not abort the batch; its error is reported in its result instead.\n"
+        "This RPC is experimental and the interface may be unstable.\n"
+        ,
+        {
+            {"packages", RPCArg::Type::ARR, RPCArg::Optional::NO, "An array of packages.",
+                {
+                    {"package", RPCArg::Type::ARR, RPCArg::Optional::OMITTED, "An array of raw transactions.",
+                        {
+                            {"rawtx", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, ""},
+                        },
+                    },
+                },
+            },
+        },
+        RPCResult{
+            RPCResult::Type::ARR, "", "The result of each package, in the same order as the request",
+            {
+                {RPCResult::Type::OBJ, "", "", Cat<std::vector<RPCResult>>(
+                {
+                    {RPCResult::Type::STR, "package-msg", "\"success\" if all transactions were accepted, \"transaction failed\" if one of them was rejected, otherwise the reason the package was rejected"},
+                },
+                PackageResultDoc())},
+            },
+        },
+        RPCExamples{
+            HelpExampleCli("submitpackages", "\"[[rawtx1, rawtx2], [rawtx3, rawtx4]]\"")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+        {
+            if (!Params().IsMockableChain()) {
+                throw std::runtime_error("submitpackages is for regression testing (-regtest mode) only");
+            }
+            RPCTypeCheck(request.params, {
+                UniValue::VARR,
+            });
+            const UniValue& raw_packages = request.params[0].get_array();
+            if (raw_packages.size() < 1 || raw_packages.size() > MAX_SUBMIT_PACKAGES) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                   "Array must contain between 1 and " + ToString(MAX_SUBMIT_PACKAGES) + " packages.");
+            }
+            std::vector<Package> packages;
+            packages.reserve(raw_packages.size());
+            for (const auto& raw_package : raw_packages.getValues()) {
+                packages.push_back(DecodePackage(raw_package.get_array()));
+            }
+
+            NodeContext& node = EnsureAnyNodeContext(request.context);
+            CTxMemPool& mempool = EnsureMemPool(node);
+            Chainstate& chainstate = EnsureChainman(node).ActiveChainstate();
+            const auto package_results = WITH_LOCK(::cs_main, return ProcessNewPackages(chainstate, mempool, packages, /*test_accept=*/ false));
+            CHECK_NONFATAL(package_results.size() == packages.size());
+
+            UniValue rpc_result{UniValue::VARR};
+            for (size_t i{0}; i < packages.size(); ++i) {
+                const auto& package_result{package_results[i]};
+                for (const auto& tx : packages[i]) {
+                    // Only broadcast transactions that made it into the mempool.
+                    auto it = package_result.m_tx_results.find(tx->GetWitnessHash());
+                    if (it == package_result.m_tx_results.end() ||
+                        (it->second.m_result_type != MempoolAcceptResult::ResultType::VALID &&
+                         it->second.m_result_type != MempoolAcceptResult::ResultType::MEMPOOL_ENTRY)) continue;
+                    std::string err_string;
+                    const auto err = BroadcastTransaction(node, tx, err_string, 0, true, true);
+                    if (err != TransactionError::OK) {
+                        throw JSONRPCTransactionError(err, strprintf("transaction broadcast failed: %s", err_string));
                     }
                 }
-                tx_result_map.pushKV(tx->GetWitnessHash().GetHex(), result_inner);
-            }
-            rpc_result.pushKV("tx-results", tx_result_map);
-            if (package_result.m_package_feerate.has_value()) {
-                rpc_result.pushKV("package-feerate", ValueFromAmount(package_result.m_package_feerate.value().GetFeePerK()));
+                // A transaction may fail individually without a package-wide error, see AcceptPackage().
+                std::string package_msg{"success"};
+                if (package_result.m_state.IsInvalid()) {
+                    package_msg = package_result.m_state.GetRejectReason();
+                } else if (std::any_of(package_result.m_tx_results.cbegin(), package_result.m_tx_results.cend(),
+                                       [](const auto& res) { return res.second.m_state.IsInvalid(); })) {
+                    package_msg = "transaction failed";
+                }
+                UniValue result{UniValue::VOBJ};
+                result.pushKV("package-msg", package_msg);
+                result.pushKVs(PackageResultToJSON(packages[i], package_result));
+                rpc_result.push_back(result);
             }
-            UniValue replaced_list(UniValue::VARR);
-            for (const uint256& hash : replaced_txids) replaced_list.push_back(hash.ToString());
-            rpc_result.pushKV("replaced-transactions", replaced_list);
             return rpc_result;
         },
     };
@@ -897,6 +1045,7 @@ void RegisterMempoolRPCCommands(CRPCTable& t)
         {"blockchain", &getrawmempool},
         {"blockchain", &savemempool},
         {"hidden", &submitpackage},
+        {"hidden", &submitpackages},
     };
     for (const auto& c : commands) {
         t.appendCommand(c.name, &c);
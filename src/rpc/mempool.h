@@ -5,6 +5,10 @@
 #ifndef BITCOIN_RPC_MEMPOOL_H
 #define BITCOIN_RPC_MEMPOOL_H
 
+#include <cstddef>
+#include <functional>
+#include <string>
+
 class CTxMemPool;
 class UniValue;
 
@@ -14,4 +18,13 @@ UniValue MempoolInfoToJSON(const CTxMemPool& pool);
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
 
+/**
+ * Verbose mempool to JSON text, written in parts of up to batch_size entries.
+ * Unlike MempoolToJSON, this holds the mempool lock only while building each
+ * part, so the output is not an atomic view of the mempool: transactions
+ * added meanwhile are left out, as are transactions removed before their
+ * part is built.
+ */
+void MempoolToJSONStream(const CTxMemPool& pool, size_t batch_size, const std::function<void(std::string&&)>& write);
+
 #endif // BITCOIN_RPC_MEMPOOL_H
@@ -465,7 +465,9 @@ static RPCHelpMan prioritisetransaction()
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Priority is no longer supported, dummy argument to prioritisetransaction must be 0.");
     }
 
-    EnsureAnyMemPool(request.context).PrioritiseTransaction(hash, nAmount);
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    EnsureMemPool(node).PrioritiseTransaction(hash, nAmount);
+    if (node.block_template_cache) node.block_template_cache->Invalidate();
     return true;
 },
     };
@@ -732,8 +734,10 @@ static RPCHelpMan getblocktemplate()
     static CBlockIndex* pindexPrev;
     static int64_t time_start;
     static std::unique_ptr<CBlockTemplate> pblocktemplate;
+    // Without the template cache, rebuilding is expensive, so mempool changes
+    // are picked up at most every 5 seconds.
     if (pindexPrev != active_chain.Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - time_start > 5))
+        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && (node.block_template_cache || GetTime() - time_start > 5)))
     {
         // Clear pindexPrev so future calls make a new block, despite any failures from here on
         pindexPrev = nullptr;
@@ -745,7 +749,11 @@ static RPCHelpMan getblocktemplate()
 
         // Create new block
         CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler{active_chainstate, &mempool}.CreateNewBlock(scriptDummy);
+        if (node.block_template_cache) {
+            pblocktemplate = node.block_template_cache->CreateNewBlock(scriptDummy);
+        } else {
+            pblocktemplate = BlockAssembler{active_chainstate, &mempool}.CreateNewBlock(scriptDummy);
+        }
         if (!pblocktemplate)
             throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
 
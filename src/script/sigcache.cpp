@@ -122,6 +122,10 @@ bool CachingTransactionSignatureChecker::VerifySchnorrSignature(Span<const unsig
     uint256 entry;
     signatureCache.ComputeEntrySchnorr(entry, sighash, sig, pubkey);
     if (signatureCache.Get(entry, !store)) return true;
+    if (m_batch) {
+        m_batch->Add(pubkey, sighash, sig);
+        return true;
+    }
     if (!TransactionSignatureChecker::VerifySchnorrSignature(sig, pubkey, sighash)) return false;
     if (store) signatureCache.Set(entry);
     return true;
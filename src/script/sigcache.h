@@ -19,14 +19,26 @@
 static constexpr size_t DEFAULT_MAX_SIG_CACHE_BYTES{32 << 20};
 
 class CPubKey;
-
+class SchnorrSignatureBatch;
+
+/**
+ * Signature checker that skips signatures found in the signature cache.
+ *
+ * If a batch is passed, Schnorr signatures that are not in the cache are
+ * added to it and treated as valid instead of being verified. This is sound
+ * because a failing Schnorr signature check with a non-empty signature always
+ * fails the script (BIP340/BIP342), but the caller must then consider the
+ * script failed unless the batch verifies. Deferred signatures are not stored
+ * in the cache.
+ */
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool store;
+    SchnorrSignatureBatch* m_batch;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn, MissingDataBehavior::ASSERT_FAIL), store(storeIn) {}
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn, SchnorrSignatureBatch* batch = nullptr) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn, MissingDataBehavior::ASSERT_FAIL), store(storeIn), m_batch(batch) {}
 
     bool VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
     bool VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const override;
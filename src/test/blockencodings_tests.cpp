@@ -49,8 +49,9 @@ static CBlock BuildBlockTestCase() {
 }
 
 // Number of shared use_counts we expect for a tx we haven't touched
-// (block + mempool + our copy from the GetSharedTx call)
-constexpr long SHARED_TX_OFFSET{3};
+// (block + mempool + the mempool snapshot's txid and wtxid entries + our copy
+// from the GetSharedTx call)
+constexpr long SHARED_TX_OFFSET{5};
 
 BOOST_AUTO_TEST_CASE(SimpleRoundTripTest)
 {
@@ -300,6 +301,38 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(MempoolScanOrderRTTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    TestMemPoolEntryHelper entry;
+    CBlock block(BuildBlockTestCase());
+
+    LOCK2(cs_main, pool.cs);
+    // Put more than twice a block's worth of weight above vtx[2] by ancestor
+    // feerate, so that it is only found when the whole mempool is scanned
+    CMutableTransaction filler;
+    filler.vin.resize(1);
+    filler.vin[0].scriptSig.resize(100000);
+    filler.vout.resize(1);
+    for (int i = 0; i < 25; i++) {
+        filler.vin[0].prevout.hash = InsecureRand256();
+        pool.addUnchecked(entry.Fee(10 * COIN).FromTx(filler));
+    }
+    pool.addUnchecked(entry.Fee(20 * COIN).FromTx(block.vtx[1]));
+    pool.addUnchecked(entry.Fee(0).FromTx(block.vtx[2]));
+
+    CBlockHeaderAndShortTxIDs shortIDs{block};
+    PartiallyDownloadedBlock partialBlock(&pool);
+    BOOST_CHECK(partialBlock.InitData(shortIDs, extra_txn) == READ_STATUS_OK);
+    BOOST_CHECK(partialBlock.IsTxAvailable(0));
+    BOOST_CHECK(partialBlock.IsTxAvailable(1));
+    BOOST_CHECK(partialBlock.IsTxAvailable(2));
+
+    CBlock block2;
+    BOOST_CHECK(partialBlock.FillBlock(block2, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block.GetHash().ToString(), block2.GetHash().ToString());
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
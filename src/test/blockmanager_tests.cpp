@@ -8,8 +8,11 @@
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
+#include <test/util/logging.h>
 #include <test/util/setup_common.h>
 
+#include <cstdio>
+
 using node::BlockManager;
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
 
@@ -39,4 +42,114 @@ BOOST_AUTO_TEST_CASE(blockmanager_find_block_pos)
     BOOST_CHECK_EQUAL(actual.nPos, BLOCK_SERIALIZATION_HEADER_SIZE + ::GetSerializeSize(params->GenesisBlock(), CLIENT_VERSION) + BLOCK_SERIALIZATION_HEADER_SIZE);
 }
 
+BOOST_AUTO_TEST_CASE(blockmap_stable_entries)
+{
+    node::BlockMap map;
+    std::vector<std::pair<uint256, CBlockIndex*>> inserted;
+    // Span several chunks and table resizes.
+    for (int i = 0; i < 5000; ++i) {
+        const uint256 hash{InsecureRand256()};
+        const auto [it, is_new]{map.try_emplace(hash)};
+        BOOST_REQUIRE(is_new);
+        BOOST_CHECK(it->first == hash);
+        it->second.nHeight = i;
+        inserted.emplace_back(hash, &it->second);
+    }
+    BOOST_CHECK_EQUAL(map.size(), inserted.size());
+
+    for (const auto& [hash, pindex] : inserted) {
+        const auto it{map.find(hash)};
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(&it->second, pindex);
+        BOOST_CHECK_EQUAL(map.count(hash), 1U);
+        // An existing entry is returned as is.
+        const auto [existing, is_new]{map.try_emplace(hash)};
+        BOOST_CHECK(!is_new);
+        BOOST_CHECK_EQUAL(&existing->second, pindex);
+    }
+    BOOST_CHECK(map.find(InsecureRand256()) == map.end());
+    BOOST_CHECK_EQUAL(map.count(InsecureRand256()), 0U);
+
+    // Entries are visited in insertion order.
+    int height{0};
+    for (const auto& [hash, index] : map) {
+        BOOST_CHECK(hash == inserted[height].first);
+        BOOST_CHECK_EQUAL(index.nHeight, height);
+        ++height;
+    }
+    BOOST_CHECK_EQUAL(height, 5000);
+
+    map.reserve(20000);
+    BOOST_CHECK_EQUAL(&map.find(inserted.back().first)->second, inserted.back().second);
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+    BOOST_CHECK(map.find(inserted.front().first) == map.end());
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_block_index_snapshot, TestChain100Setup)
+{
+    const auto& consensus_params{Params().GetConsensus()};
+    BlockManager& blockman{m_node.chainman->m_blockman};
+    LOCK(::cs_main);
+    m_node.chainman->ActiveChainstate().ForceFlushStateToDisk();
+    BOOST_REQUIRE(blockman.WriteBlockIndexSnapshot());
+
+    const auto check_loaded{[&](BlockManager& loaded) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+        BOOST_REQUIRE_EQUAL(loaded.m_block_index.size(), blockman.m_block_index.size());
+        for (const auto& [hash, index] : blockman.m_block_index) {
+            const CBlockIndex* pindex{loaded.LookupBlockIndex(hash)};
+            BOOST_REQUIRE(pindex);
+            BOOST_CHECK_EQUAL(pindex->nHeight, index.nHeight);
+            BOOST_CHECK_EQUAL(pindex->pprev ? pindex->pprev->GetBlockHash() : uint256{}, index.pprev ? index.pprev->GetBlockHash() : uint256{});
+            BOOST_CHECK_EQUAL(pindex->pskip ? pindex->pskip->GetBlockHash() : uint256{}, index.pskip ? index.pskip->GetBlockHash() : uint256{});
+            BOOST_CHECK(pindex->GetBlockPos() == index.GetBlockPos());
+            BOOST_CHECK(pindex->GetUndoPos() == index.GetUndoPos());
+            BOOST_CHECK_EQUAL(pindex->nStatus, index.nStatus);
+            BOOST_CHECK_EQUAL(pindex->nTx, index.nTx);
+            BOOST_CHECK_EQUAL(pindex->nChainTx, index.nChainTx);
+            BOOST_CHECK(pindex->nChainWork == index.nChainWork);
+            BOOST_CHECK_EQUAL(pindex->nTimeMax, index.nTimeMax);
+            BOOST_CHECK_EQUAL(pindex->GetBlockHeader().GetHash(), hash);
+        }
+    }};
+
+    // The first load uses the snapshot, which can only be used once.
+    BlockManager loaded{};
+    loaded.m_block_tree_db = std::move(blockman.m_block_tree_db);
+    {
+        ASSERT_DEBUG_LOG("block index entries from snapshot");
+        BOOST_REQUIRE(loaded.LoadBlockIndexDB(consensus_params));
+    }
+    check_loaded(loaded);
+
+    BlockManager reloaded{};
+    reloaded.m_block_tree_db = std::move(loaded.m_block_tree_db);
+    BlockIndexSnapshotInfo info;
+    BOOST_CHECK(!reloaded.m_block_tree_db->ReadBlockIndexSnapshot(info));
+    BOOST_REQUIRE(reloaded.LoadBlockIndexDB(consensus_params));
+    check_loaded(reloaded);
+
+    // A snapshot that was tampered with is ignored.
+    blockman.m_block_tree_db = std::move(reloaded.m_block_tree_db);
+    BOOST_REQUIRE(blockman.WriteBlockIndexSnapshot());
+    {
+        FILE* file{fsbridge::fopen(gArgs.GetDataDirNet() / "blocks" / "blockindex.dat", "rb+")};
+        BOOST_REQUIRE(file);
+        BOOST_REQUIRE_EQUAL(std::fseek(file, -1, SEEK_END), 0);
+        const int last_byte{std::fgetc(file)};
+        BOOST_REQUIRE_EQUAL(std::fseek(file, -1, SEEK_END), 0);
+        std::fputc(last_byte ^ 0xff, file);
+        std::fclose(file);
+    }
+    BlockManager corrupted{};
+    corrupted.m_block_tree_db = std::move(blockman.m_block_tree_db);
+    {
+        ASSERT_DEBUG_LOG("is corrupt, ignoring it");
+        BOOST_REQUIRE(corrupted.LoadBlockIndexDB(consensus_params));
+    }
+    check_loaded(corrupted);
+    blockman.m_block_tree_db = std::move(corrupted.m_block_tree_db);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
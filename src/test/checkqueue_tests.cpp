@@ -10,6 +10,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
@@ -69,6 +70,32 @@ struct FailingCheck {
     };
 };
 
+struct BatchedCheck {
+    struct Batch {
+        static std::atomic<size_t> n_verified;
+        std::vector<bool> results;
+        bool Verify() const
+        {
+            n_verified.fetch_add(results.size(), std::memory_order_relaxed);
+            return std::find(results.begin(), results.end(), false) == results.end();
+        }
+        void clear() { results.clear(); }
+    };
+    bool fails{false};
+    BatchedCheck() = default;
+    explicit BatchedCheck(bool _fails) : fails(_fails) {}
+    bool operator()(Batch& batch) const
+    {
+        // Defer the outcome to the batch.
+        batch.results.push_back(!fails);
+        return true;
+    }
+    void swap(BatchedCheck& x) noexcept
+    {
+        std::swap(fails, x.fails);
+    };
+};
+
 struct UniqueCheck {
     static Mutex m;
     static std::unordered_multiset<size_t> results GUARDED_BY(m);
@@ -153,11 +180,13 @@ Mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
+std::atomic<size_t> BatchedCheck::Batch::n_verified{0};
 
 // Queue Typedefs
 typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
 typedef CCheckQueue<FakeCheck> Standard_Queue;
 typedef CCheckQueue<FailingCheck> Failing_Queue;
+typedef CCheckQueue<BatchedCheck> Batched_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
@@ -252,6 +281,32 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Catches_Failure)
     }
     fail_queue->StopWorkerThreads();
 }
+/** Test that checks defining a Batch are verified through it */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Batch)
+{
+    auto batched_queue = std::make_unique<Batched_Queue>(QUEUE_BATCH_SIZE);
+    batched_queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
+
+    for (const size_t total : {0, 1, 10, 1000, 10000}) {
+        BatchedCheck::Batch::n_verified = 0;
+        CCheckQueueControl<BatchedCheck> control(batched_queue.get());
+        std::vector<BatchedCheck> vChecks(total);
+        control.Add(vChecks);
+        BOOST_REQUIRE(control.Wait());
+        BOOST_REQUIRE_EQUAL(BatchedCheck::Batch::n_verified, total);
+    }
+
+    // A failure deferred to the batch fails the whole run.
+    for (const size_t total : {1, 10, 1000, 10000}) {
+        CCheckQueueControl<BatchedCheck> control(batched_queue.get());
+        std::vector<BatchedCheck> vChecks(total);
+        vChecks[InsecureRandRange(total)].fails = true;
+        control.Add(vChecks);
+        BOOST_REQUIRE(!control.Wait());
+    }
+    batched_queue->StopWorkerThreads();
+}
+
 // Test that a block validation which fails does not interfere with
 // future blocks, ie, the bad state is cleared.
 BOOST_AUTO_TEST_CASE(test_CheckQueue_Recovers_From_Failure)
@@ -11,6 +11,7 @@
 #include <uint256.h>
 #include <undo.h>
 #include <util/strencodings.h>
+#include <util/threadpool.h>
 
 #include <map>
 #include <vector>
@@ -877,4 +878,103 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_prefetch)
+{
+    CCoinsViewDB db_base{"test", /*nCacheSize=*/1 << 23, /*fMemory=*/true, /*fWipe=*/false};
+    std::vector<COutPoint> outpoints;
+    {
+        CCoinsViewCacheTest writer{&db_base};
+        for (int i = 0; i < 200; ++i) {
+            COutPoint outpoint{InsecureRand256(), uint32_t(i)};
+            Coin coin{CTxOut{i + 1, CScript() << OP_TRUE}, i, /*fCoinBaseIn=*/false};
+            writer.AddCoin(outpoint, std::move(coin), /*possible_overwrite=*/false);
+            outpoints.push_back(outpoint);
+        }
+        writer.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(writer.Flush());
+    }
+
+    CCoinsViewCacheTest cache{&db_base};
+    ThreadPool pool{"prefetch"};
+
+    // Without workers the cache is left alone; coins are fetched lazily instead.
+    BOOST_CHECK_EQUAL(cache.PrefetchCoins(outpoints, pool), 0U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+
+    pool.Start(3, SyscallSandboxPolicy::VALIDATION_PREFETCH);
+
+    // Outpoints that are already cached or missing from the database are skipped.
+    BOOST_CHECK(cache.HaveCoin(outpoints[0]));
+    std::vector<COutPoint> request{outpoints};
+    for (int i = 0; i < 10; ++i) request.emplace_back(InsecureRand256(), 0);
+    BOOST_CHECK_EQUAL(cache.PrefetchCoins(request, pool), outpoints.size() - 1);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), outpoints.size());
+    cache.SelfTest();
+    for (const COutPoint& outpoint : outpoints) {
+        BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+        // Prefetched coins are clean and can be uncached again.
+        BOOST_CHECK_EQUAL(cache.map().at(outpoint).flags, 0);
+    }
+    BOOST_CHECK_EQUAL(cache.PrefetchCoins(request, pool), 0U);
+
+    pool.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_background_writer)
+{
+    CCoinsViewDB db_base{"test", /*nCacheSize=*/1 << 23, /*fMemory=*/true, /*fWipe=*/false};
+    CCoinsViewBackgroundWriter writer{db_base};
+    BOOST_CHECK(!writer.IsWriting());
+    BOOST_CHECK_EQUAL(writer.PendingMemoryUsage(), 0U);
+
+    std::vector<COutPoint> outpoints;
+    const uint256 first_block{InsecureRand256()};
+    {
+        CCoinsViewCacheTest cache{&writer};
+        for (int i = 0; i < 1000; ++i) {
+            COutPoint outpoint{InsecureRand256(), uint32_t(i)};
+            Coin coin{CTxOut{i + 1, CScript() << OP_TRUE}, i, /*fCoinBaseIn=*/false};
+            cache.AddCoin(outpoint, std::move(coin), /*possible_overwrite=*/false);
+            outpoints.push_back(outpoint);
+        }
+        cache.SetBestBlock(first_block);
+        BOOST_CHECK(cache.Flush());
+        BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+
+        // Whether or not the write has completed, the coins are visible through the writer.
+        BOOST_CHECK(writer.GetBestBlock() == first_block);
+        for (const COutPoint& outpoint : outpoints) BOOST_CHECK(writer.HaveCoin(outpoint));
+        BOOST_CHECK(writer.Sync());
+        BOOST_CHECK(!writer.IsWriting());
+        BOOST_CHECK_EQUAL(writer.PendingMemoryUsage(), 0U);
+        BOOST_CHECK(db_base.GetBestBlock() == first_block);
+        for (const COutPoint& outpoint : outpoints) BOOST_CHECK(db_base.HaveCoin(outpoint));
+    }
+
+    // Spend half of the coins; only dirty entries are written.
+    const uint256 second_block{InsecureRand256()};
+    {
+        CCoinsViewCacheTest cache{&writer};
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            if (i % 2 == 0) {
+                BOOST_CHECK(cache.SpendCoin(outpoints[i]));
+            } else {
+                BOOST_CHECK(cache.HaveCoin(outpoints[i]));
+            }
+        }
+        cache.SetBestBlock(second_block);
+        BOOST_CHECK(cache.Flush());
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            BOOST_CHECK_EQUAL(writer.HaveCoin(outpoints[i]), i % 2 == 1);
+        }
+    }
+    // Iterating over the database waits for the write to complete.
+    std::unique_ptr<CCoinsViewCursor> cursor{writer.Cursor()};
+    BOOST_CHECK(!writer.IsWriting());
+    BOOST_CHECK(db_base.GetBestBlock() == second_block);
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        BOOST_CHECK_EQUAL(db_base.HaveCoin(outpoints[i]), i % 2 == 1);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
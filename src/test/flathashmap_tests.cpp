@@ -0,0 +1,153 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flathashmap.h>
+#include <memusage.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+
+BOOST_FIXTURE_TEST_SUITE(flathashmap_tests, BasicTestingSetup)
+
+namespace {
+//! Weak hash that maps many keys to the same slots, to exercise probing.
+struct CollidingHasher {
+    size_t operator()(uint32_t key) const { return size_t(key % 37) * 0x9e3779b97f4a7c15ULL; }
+};
+
+//! Value type that counts live instances, to catch leaks and double destruction.
+struct Counted {
+    static int live;
+    std::string data;
+    explicit Counted(std::string d = {}) : data(std::move(d)) { ++live; }
+    Counted(const Counted& other) : data(other.data) { ++live; }
+    Counted(Counted&& other) : data(std::move(other.data)) { ++live; }
+    Counted& operator=(const Counted&) = default;
+    ~Counted() { --live; }
+};
+int Counted::live = 0;
+
+template <typename Map>
+void CheckEqual(const Map& map, const std::map<uint32_t, std::string>& model)
+{
+    BOOST_CHECK_EQUAL(map.size(), model.size());
+    size_t iterated{0};
+    for (const auto& [key, value] : map) {
+        const auto it{model.find(key)};
+        BOOST_REQUIRE(it != model.end());
+        BOOST_CHECK_EQUAL(value.data, it->second);
+        ++iterated;
+    }
+    BOOST_CHECK_EQUAL(iterated, model.size());
+    for (const auto& [key, value] : model) {
+        const auto it{map.find(key)};
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(it->second.data, value);
+    }
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(flathashmap_random_operations)
+{
+    {
+        FlatHashMap<uint32_t, Counted, CollidingHasher> map;
+        std::map<uint32_t, std::string> model;
+        BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+        for (int i = 0; i < 20000; ++i) {
+            const uint32_t key{uint32_t(InsecureRandRange(500))};
+            const std::string value{std::to_string(InsecureRand32())};
+            switch (InsecureRandRange(4)) {
+            case 0: {
+                const auto [it, inserted] = map.try_emplace(key, value);
+                const auto [model_it, model_inserted] = model.try_emplace(key, value);
+                BOOST_CHECK_EQUAL(inserted, model_inserted);
+                BOOST_CHECK_EQUAL(it->second.data, model_it->second);
+                break;
+            }
+            case 1:
+                map[key].data = value;
+                model[key] = value;
+                break;
+            case 2:
+                BOOST_CHECK_EQUAL(map.erase(key), model.erase(key));
+                break;
+            case 3:
+                BOOST_CHECK_EQUAL(map.count(key), model.count(key));
+                break;
+            }
+            BOOST_CHECK_EQUAL(size_t(Counted::live), model.size());
+        }
+        CheckEqual(map, model);
+        BOOST_CHECK(memusage::DynamicUsage(map) >= map.bucket_count() * sizeof(std::pair<const uint32_t, Counted>));
+
+        map.clear();
+        BOOST_CHECK(map.empty());
+        BOOST_CHECK(map.begin() == map.end());
+        BOOST_CHECK_EQUAL(Counted::live, 0);
+        BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+        map.try_emplace(1, "one");
+    }
+    BOOST_CHECK_EQUAL(Counted::live, 0);
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_erase_while_iterating)
+{
+    FlatHashMap<uint32_t, Counted, CollidingHasher> map;
+    std::map<uint32_t, std::string> model;
+    for (uint32_t key = 0; key < 1000; ++key) {
+        map.try_emplace(key, std::to_string(key));
+        model.emplace(key, std::to_string(key));
+    }
+
+    // Both erase styles used by BatchWrite implementations visit every element once.
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->first % 3 == 0) {
+            BOOST_CHECK_EQUAL(model.erase(it->first), 1U);
+            map.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    CheckEqual(map, model);
+    size_t visited{0};
+    for (auto it = map.begin(); it != map.end(); it = map.erase(it)) {
+        BOOST_CHECK_EQUAL(model.erase(it->first), 1U);
+        ++visited;
+    }
+    BOOST_CHECK_EQUAL(visited, 666U);
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(model.empty());
+
+    // A table full of tombstones is cleaned up instead of grown.
+    const size_t buckets{map.bucket_count()};
+    for (uint32_t key = 0; key < 10000; ++key) {
+        map.try_emplace(key, std::to_string(key));
+        map.erase(key);
+    }
+    BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+    BOOST_CHECK_EQUAL(Counted::live, 0);
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_reserve)
+{
+    FlatHashMap<uint32_t, uint32_t> map;
+    map.reserve(1000);
+    const size_t buckets{map.bucket_count()};
+    BOOST_CHECK(buckets >= 1000);
+    for (uint32_t key = 0; key < 1000; ++key) map.emplace(key, key * 2);
+    BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+    for (uint32_t key = 0; key < 1000; ++key) BOOST_CHECK_EQUAL(map.at(key), key * 2);
+    BOOST_CHECK_THROW(map.at(1000), std::out_of_range);
+
+    // Elements survive growing the table.
+    for (uint32_t key = 1000; key < 5000; ++key) map.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(key * 2));
+    BOOST_CHECK(map.bucket_count() > buckets);
+    for (uint32_t key = 0; key < 5000; ++key) BOOST_CHECK_EQUAL(map.at(key), key * 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
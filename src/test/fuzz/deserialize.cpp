@@ -36,6 +36,7 @@
 
 #include <test/fuzz/fuzz.h>
 
+using node::SnapshotChunkHeader;
 using node::SnapshotMetadata;
 
 namespace {
@@ -312,6 +313,10 @@ FUZZ_TARGET_DESERIALIZE(snapshotmetadata_deserialize, {
     SnapshotMetadata snapshot_metadata;
     DeserializeFromFuzzingInput(buffer, snapshot_metadata);
 })
+FUZZ_TARGET_DESERIALIZE(snapshotchunkheader_deserialize, {
+    SnapshotChunkHeader snapshot_chunk_header;
+    DeserializeFromFuzzingInput(buffer, snapshot_chunk_header);
+})
 FUZZ_TARGET_DESERIALIZE(uint160_deserialize, {
     uint160 u160;
     DeserializeFromFuzzingInput(buffer, u160);
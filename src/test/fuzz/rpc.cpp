@@ -161,6 +161,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "submitblock",
     "submitheader",
     "submitpackage",
+    "submitpackages",
     "syncwithvalidationinterfacequeue",
     "testmempoolaccept",
     "uptime",
@@ -48,5 +48,5 @@ FUZZ_TARGET_INIT(validation_load_mempool, initialize_validation_load_mempool)
         return fuzzed_file_provider.open();
     };
     (void)chainstate.LoadMempool(MempoolPath(g_setup->m_args), fuzzed_fopen);
-    (void)DumpMempool(pool, MempoolPath(g_setup->m_args), fuzzed_fopen, true);
+    (void)DumpMempool(pool, MempoolPath(g_setup->m_args), chainstate, fuzzed_fopen, true);
 }
@@ -145,6 +145,24 @@ BOOST_AUTO_TEST_CASE(siphash)
         BOOST_CHECK_EQUAL(SipHashUint256(k1, k2, x), sip256.Finalize());
         BOOST_CHECK_EQUAL(SipHashUint256Extra(k1, k2, x, n), sip288.Finalize());
     }
+
+    // Check consistency between SipHashUint256Batch and SipHashUint256, for all batch sizes
+    // (and therefore all combinations of 8-way and single hashes) up to 19.
+    std::vector<uint256> vals(19);
+    std::vector<const uint256*> ptrs;
+    for (auto& val : vals) {
+        val = InsecureRand256();
+        ptrs.push_back(&val);
+    }
+    for (size_t count = 0; count <= vals.size(); ++count) {
+        uint64_t k1 = ctx.rand64();
+        uint64_t k2 = ctx.rand64();
+        std::vector<uint64_t> out(count);
+        SipHashUint256Batch(k1, k2, ptrs.data(), out.data(), count);
+        for (size_t i = 0; i < count; ++i) {
+            BOOST_CHECK_EQUAL(out[i], SipHashUint256(k1, k2, vals[i]));
+        }
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -12,7 +12,9 @@
 #include <util/string.h>
 #include <util/system.h>
 
+#include <array>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -344,4 +346,37 @@ BOOST_AUTO_TEST_CASE(bip340_test_vectors)
     }
 }
 
+BOOST_AUTO_TEST_CASE(schnorr_signature_batch)
+{
+    SchnorrSignatureBatch batch;
+    BOOST_CHECK(batch.Verify());
+
+    std::vector<std::tuple<XOnlyPubKey, uint256, std::array<unsigned char, 64>>> sigs;
+    for (int i = 0; i < 20; ++i) {
+        CKey key;
+        key.MakeNewKey(true);
+        const uint256 msg{InsecureRand256()};
+        std::array<unsigned char, 64> sig;
+        BOOST_CHECK(key.SignSchnorr(msg, sig, nullptr, InsecureRand256()));
+        sigs.emplace_back(XOnlyPubKey{key.GetPubKey()}, msg, sig);
+    }
+    for (const auto& [pubkey, msg, sig] : sigs) batch.Add(pubkey, msg, sig);
+    BOOST_CHECK_EQUAL(batch.size(), sigs.size());
+    BOOST_CHECK(batch.Verify());
+
+    // A single invalid signature, in any position, fails the whole batch.
+    for (size_t bad = 0; bad < sigs.size(); ++bad) {
+        batch.clear();
+        for (size_t i = 0; i < sigs.size(); ++i) {
+            const auto& [pubkey, msg, sig] = sigs[i];
+            batch.Add(pubkey, i == bad ? InsecureRand256() : msg, sig);
+        }
+        BOOST_CHECK(!batch.Verify());
+    }
+
+    batch.clear();
+    BOOST_CHECK_EQUAL(batch.size(), 0U);
+    BOOST_CHECK(batch.Verify());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <policy/policy.h>
+#include <policy/rbf.h>
 #include <txmempool.h>
 #include <util/system.h>
 #include <util/time.h>
@@ -10,6 +11,7 @@
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
+#include <thread>
 #include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(mempool_tests, TestingSetup)
@@ -800,4 +802,187 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTestsDiamond)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+static CTransactionRef MakeClusterTx(const std::vector<COutPoint>& inputs, int tag)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(std::max<size_t>(inputs.size(), 1));
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        tx.vin[i].prevout = inputs[i];
+    }
+    tx.vin[0].scriptSig = CScript() << tag;
+    tx.vout.resize(2);
+    for (CTxOut& out : tx.vout) {
+        out.scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        out.nValue = COIN;
+    }
+    return MakeTransactionRef(tx);
+}
+
+static void CheckClusters(const CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    size_t tx_count{0};
+    for (const TxMempoolCluster* cluster : pool.GetClusters()) {
+        // Parents come before their children
+        std::set<uint256> seen;
+        for (const CTxMemPoolEntry* entry : cluster->txs) {
+            for (const CTxMemPoolEntry& parent : entry->GetMemPoolParentsConst()) {
+                BOOST_CHECK(seen.count(parent.GetTx().GetHash()));
+            }
+            seen.insert(entry->GetTx().GetHash());
+        }
+        // Chunks add up, and their feerates do not increase
+        size_t pos{0};
+        for (size_t i = 0; i < cluster->chunks.size(); ++i) {
+            const TxMempoolCluster::Chunk& chunk{cluster->chunks[i]};
+            CAmount fee{0};
+            int64_t size{0};
+            for (size_t j = 0; j < chunk.count; ++j, ++pos) {
+                fee += cluster->txs[pos]->GetModifiedFee();
+                size += cluster->txs[pos]->GetTxSize();
+            }
+            BOOST_CHECK_EQUAL(chunk.fee, fee);
+            BOOST_CHECK_EQUAL(chunk.size, size);
+            if (i > 0) {
+                const TxMempoolCluster::Chunk& prev{cluster->chunks[i - 1]};
+                BOOST_CHECK(prev.fee * chunk.size >= chunk.fee * prev.size);
+            }
+        }
+        BOOST_CHECK_EQUAL(pos, cluster->txs.size());
+        tx_count += cluster->txs.size();
+    }
+    BOOST_CHECK_EQUAL(tx_count, pool.size());
+}
+
+BOOST_AUTO_TEST_CASE(MempoolClusterTest)
+{
+    CTxMemPool::Options mempool_opts{MemPoolOptionsForTest(m_node)};
+    mempool_opts.track_clusters = true;
+    CTxMemPool pool{mempool_opts};
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+    const auto add{[&](const CTransactionRef& tx, CAmount fee) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, pool.cs) {
+        pool.addUnchecked(entry.Fee(fee).FromTx(tx));
+        return *pool.GetIter(tx->GetHash());
+    }};
+
+    const CTransactionRef tx_a{MakeClusterTx({}, 1)};
+    const CTransactionRef tx_b{MakeClusterTx({COutPoint{tx_a->GetHash(), 0}}, 2)};
+    const CTransactionRef tx_c{MakeClusterTx({}, 3)};
+    const auto it_a{add(tx_a, 1000)};
+    const auto it_b{add(tx_b, 10000)};
+    const auto it_c{add(tx_c, 3000)};
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 2U);
+    CheckClusters(pool);
+
+    // The child pays for its parent, so they form a single chunk
+    BOOST_CHECK_EQUAL(pool.GetCluster(it_a).chunks.size(), 1U);
+    const CFeeRate chunk_feerate{11000, uint32_t(it_a->GetTxSize() + it_b->GetTxSize())};
+    BOOST_CHECK(pool.GetChunkFeeRate(it_a) == chunk_feerate);
+    BOOST_CHECK(pool.GetChunkFeeRate(it_b) == chunk_feerate);
+
+    // Replacing tx_a requires beating the feerate of its chunk, not just its own
+    const CFeeRate replacement_feerate{4000, uint32_t(it_a->GetTxSize())};
+    BOOST_CHECK(replacement_feerate < chunk_feerate);
+    BOOST_CHECK(!PaysMoreThanConflicts({it_a}, replacement_feerate, uint256::ONE));
+    BOOST_CHECK(PaysMoreThanConflictChunks(pool, {it_a}, replacement_feerate, uint256::ONE));
+    BOOST_CHECK(!PaysMoreThanConflictChunks(pool, {it_c}, replacement_feerate, uint256::ONE));
+
+    // A child without fees ends up in a chunk of its own
+    const CTransactionRef tx_d{MakeClusterTx({COutPoint{tx_b->GetHash(), 0}}, 4)};
+    const auto it_d{add(tx_d, 0)};
+    BOOST_CHECK_EQUAL(pool.GetCluster(it_d).chunks.size(), 2U);
+    BOOST_CHECK(pool.GetChunkFeeRate(it_d) == CFeeRate(0));
+    BOOST_CHECK(pool.GetChunkFeeRate(it_a) == chunk_feerate);
+
+    // Spending from both clusters merges them
+    const CTransactionRef tx_e{MakeClusterTx({COutPoint{tx_c->GetHash(), 0}, COutPoint{tx_d->GetHash(), 0}}, 5)};
+    const auto it_e{add(tx_e, 50000)};
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 1U);
+    BOOST_CHECK_EQUAL(pool.GetCluster(it_e).txs.size(), 5U);
+    CheckClusters(pool);
+
+    // ... and removing it splits them again
+    pool.removeRecursive(*tx_e, REMOVAL_REASON_DUMMY);
+    BOOST_CHECK_EQUAL(pool.GetClusters().size(), 2U);
+    CheckClusters(pool);
+
+    // Fee deltas are taken into account
+    pool.PrioritiseTransaction(tx_c->GetHash(), 20000);
+    BOOST_CHECK(pool.GetChunkFeeRate(it_c) == CFeeRate(23000, it_c->GetTxSize()));
+
+    // Confirming tx_a leaves tx_b as the root of its cluster
+    pool.removeForBlock({tx_a}, 1);
+    BOOST_CHECK_EQUAL(pool.GetCluster(it_b).txs.size(), 2U);
+    CheckClusters(pool);
+
+    // Eviction removes the chunk that would be mined last
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_d->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_b->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_c->GetHash())));
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_b->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_c->GetHash())));
+    CheckClusters(pool);
+
+    // A chain with decreasing fees is evicted from its end
+    std::vector<CTransactionRef> chain{MakeClusterTx({}, 6)};
+    add(chain.back(), 31000);
+    for (int i = 0; i < 30; ++i) {
+        chain.push_back(MakeClusterTx({COutPoint{chain.back()->GetHash(), 0}}, 7 + i));
+        add(chain.back(), 1000 * (30 - i));
+    }
+    BOOST_CHECK_EQUAL(pool.GetCluster(*pool.GetIter(chain.back()->GetHash())).chunks.size(), chain.size());
+    CheckClusters(pool);
+    pool.TrimToSize(pool.DynamicMemoryUsage() / 2);
+    BOOST_CHECK(pool.exists(GenTxid::Txid(chain.front()->GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(chain.back()->GetHash())));
+    CheckClusters(pool);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolSnapshotTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    TestMemPoolEntryHelper entry;
+    const CTransactionRef tx_a{MakeClusterTx({}, 1)};
+    const CTransactionRef tx_b{MakeClusterTx({COutPoint{tx_a->GetHash(), 0}}, 2)};
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.addUnchecked(entry.Fee(1000).FromTx(tx_a));
+        pool.addUnchecked(entry.Fee(2000).FromTx(tx_b));
+    }
+
+    // Readers do not wait for the mempool lock
+    bool exists_txid{false}, exists_wtxid{false};
+    TxMempoolInfo info;
+    CTransactionRef tx;
+    size_t count{0};
+    {
+        LOCK(pool.cs);
+        std::thread reader{[&] {
+            exists_txid = pool.exists(GenTxid::Txid(tx_a->GetHash()));
+            exists_wtxid = pool.exists(GenTxid::Wtxid(tx_b->GetWitnessHash()));
+            info = pool.info(GenTxid::Txid(tx_b->GetHash()));
+            tx = pool.get(tx_a->GetHash());
+            count = pool.GetSnapshot().GetAll().size();
+        }};
+        reader.join();
+    }
+    BOOST_CHECK(exists_txid);
+    BOOST_CHECK(exists_wtxid);
+    BOOST_CHECK_EQUAL(info.fee, 2000);
+    BOOST_CHECK(info.tx == tx_b);
+    BOOST_CHECK(tx == tx_a);
+    BOOST_CHECK_EQUAL(count, 2U);
+
+    pool.PrioritiseTransaction(tx_a->GetHash(), 500);
+    BOOST_CHECK_EQUAL(pool.info(GenTxid::Wtxid(tx_a->GetWitnessHash())).nFeeDelta, 500);
+
+    WITH_LOCK(pool.cs, pool.removeRecursive(*tx_a, REMOVAL_REASON_DUMMY));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_a->GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Wtxid(tx_b->GetWitnessHash())));
+    BOOST_CHECK(!pool.get(tx_b->GetHash()));
+    BOOST_CHECK(pool.GetSnapshot().GetAll().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
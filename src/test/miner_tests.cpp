@@ -16,15 +16,18 @@
 #include <util/system.h>
 #include <util/time.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <versionbits.h>
 
 #include <test/util/setup_common.h>
 
 #include <memory>
+#include <set>
 
 #include <boost/test/unit_test.hpp>
 
 using node::BlockAssembler;
+using node::BlockTemplateCache;
 using node::CBlockTemplate;
 
 namespace miner_tests {
@@ -651,4 +654,122 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     TestPrioritisedMining(scriptPubKey, txFirst);
 }
 
+static std::set<uint256> TemplateTxids(const CBlockTemplate& block_template)
+{
+    std::set<uint256> txids;
+    for (size_t i = 1; i < block_template.block.vtx.size(); ++i) {
+        txids.insert(block_template.block.vtx[i]->GetHash());
+    }
+    return txids;
+}
+
+BOOST_FIXTURE_TEST_CASE(CreateNewBlock_incremental, TestChain100Setup)
+{
+    CTxMemPool& mempool{*m_node.mempool};
+    const CScript script_pub_key{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    // Make the first five coinbase outputs mature
+    for (int i = 0; i < 4; ++i) {
+        CreateAndProcessBlock({}, script_pub_key);
+    }
+
+    BlockAssembler::Options options;
+    options.nBlockMaxWeight = MAX_BLOCK_WEIGHT;
+    options.blockMinFeeRate = blockMinFeeRate;
+    BlockTemplateCache cache{*m_node.chainman, mempool, options};
+    RegisterValidationInterface(&cache);
+    // Only room for two of the transactions below next to the coinbase
+    BlockAssembler::Options small_options{options};
+    small_options.nBlockMaxWeight = 5600;
+    BlockTemplateCache small_cache{*m_node.chainman, mempool, small_options};
+    RegisterValidationInterface(&small_cache);
+
+    // The cached selection must contain the same transactions as one made from scratch.
+    const auto check_template{[&](BlockTemplateCache& template_cache, const BlockAssembler::Options& template_options) {
+        SyncWithValidationInterfaceQueue();
+        const auto block_template{template_cache.CreateNewBlock(script_pub_key)};
+        BOOST_REQUIRE(block_template);
+        const auto expected{BlockAssembler{m_node.chainman->ActiveChainstate(), &mempool, template_options}.CreateNewBlock(script_pub_key)};
+        const std::set<uint256> txids{TemplateTxids(*block_template)};
+        BOOST_CHECK(txids == TemplateTxids(*expected));
+        return txids;
+    }};
+    const auto spend{[&](const CTransactionRef& input, int input_height, CAmount fee) {
+        return MakeTransactionRef(CreateValidMempoolTransaction(input, 0, input_height, coinbaseKey, script_pub_key, input->vout[0].nValue - fee));
+    }};
+
+    BOOST_CHECK(check_template(cache, options).empty());
+
+    const CTransactionRef tx_a{spend(m_coinbase_txns[0], 1, 1000)};
+    const CTransactionRef tx_b{spend(m_coinbase_txns[1], 2, 10000)};
+    BOOST_CHECK(check_template(cache, options) == std::set<uint256>({tx_a->GetHash(), tx_b->GetHash()}));
+
+    // A child is added together with the parent it depends on
+    const CTransactionRef tx_c{spend(tx_a, 0, 2000)};
+    BOOST_CHECK(check_template(cache, options) == std::set<uint256>({tx_a->GetHash(), tx_b->GetHash(), tx_c->GetHash()}));
+
+    // Selected transactions that left the mempool are dropped
+    WITH_LOCK(mempool.cs, mempool.removeRecursive(*tx_b, MemPoolRemovalReason::REPLACED));
+    BOOST_CHECK(check_template(cache, options) == std::set<uint256>({tx_a->GetHash(), tx_c->GetHash()}));
+
+    // Fee deltas are picked up after invalidation
+    mempool.PrioritiseTransaction(tx_a->GetHash(), -COIN);
+    cache.Invalidate();
+    BOOST_CHECK(check_template(cache, options).empty());
+
+    const CTransactionRef tx_d{spend(m_coinbase_txns[2], 3, 5000)};
+    const CTransactionRef tx_e{spend(m_coinbase_txns[3], 4, 10000)};
+    BOOST_CHECK(check_template(small_cache, small_options) == std::set<uint256>({tx_d->GetHash(), tx_e->GetHash()}));
+
+    // A transaction with a higher feerate replaces the worst package in a full block
+    const CTransactionRef tx_f{spend(m_coinbase_txns[4], 5, 20000)};
+    BOOST_CHECK(check_template(small_cache, small_options) == std::set<uint256>({tx_e->GetHash(), tx_f->GetHash()}));
+    BOOST_CHECK(check_template(cache, options) == std::set<uint256>({tx_d->GetHash(), tx_e->GetHash(), tx_f->GetHash()}));
+
+    UnregisterValidationInterface(&small_cache);
+    UnregisterValidationInterface(&cache);
+}
+
+BOOST_FIXTURE_TEST_CASE(CreateNewBlock_clusters, TestChain100Setup)
+{
+    const CScript script_pub_key{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    for (int i = 0; i < 2; ++i) {
+        CreateAndProcessBlock({}, script_pub_key);
+    }
+    CTxMemPool::Options mempool_opts{MemPoolOptionsForTest(m_node)};
+    mempool_opts.track_clusters = true;
+    CTxMemPool pool{mempool_opts};
+
+    const auto spend{[&](const CTransactionRef& input, int input_height, CAmount fee) {
+        return MakeTransactionRef(CreateValidMempoolTransaction(input, 0, input_height, coinbaseKey, script_pub_key, input->vout[0].nValue - fee, /*submit=*/false));
+    }};
+    const CTransactionRef parent{spend(m_coinbase_txns[0], 1, 1000)};
+    const CTransactionRef child{spend(parent, 0, 20000)};
+    const CTransactionRef other{spend(m_coinbase_txns[1], 2, 5000)};
+    {
+        LOCK2(cs_main, pool.cs);
+        TestMemPoolEntryHelper entry;
+        pool.addUnchecked(entry.Fee(1000).FromTx(parent));
+        pool.addUnchecked(entry.Fee(20000).FromTx(child));
+        pool.addUnchecked(entry.Fee(5000).FromTx(other));
+    }
+
+    // The child pays for its parent, so both come before the other transaction
+    BlockAssembler::Options options;
+    options.nBlockMaxWeight = MAX_BLOCK_WEIGHT;
+    options.blockMinFeeRate = blockMinFeeRate;
+    auto block_template{BlockAssembler{m_node.chainman->ActiveChainstate(), &pool, options}.CreateNewBlock(script_pub_key)};
+    BOOST_REQUIRE_EQUAL(block_template->block.vtx.size(), 4U);
+    BOOST_CHECK(block_template->block.vtx[1]->GetHash() == parent->GetHash());
+    BOOST_CHECK(block_template->block.vtx[2]->GetHash() == child->GetHash());
+    BOOST_CHECK(block_template->block.vtx[3]->GetHash() == other->GetHash());
+    BOOST_CHECK_EQUAL(block_template->vTxFees[1] + block_template->vTxFees[2], 21000);
+
+    // Only room for two transactions, which go to the chunk with the higher feerate
+    options.nBlockMaxWeight = 5600;
+    block_template = BlockAssembler{m_node.chainman->ActiveChainstate(), &pool, options}.CreateNewBlock(script_pub_key);
+    BOOST_REQUIRE_EQUAL(block_template->block.vtx.size(), 3U);
+    BOOST_CHECK(block_template->block.vtx[1]->GetHash() == parent->GetHash());
+    BOOST_CHECK(block_template->block.vtx[2]->GetHash() == child->GetHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -12,6 +12,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <thread>
+
 BOOST_FIXTURE_TEST_SUITE(policyestimator_tests, ChainTestingSetup)
 
 BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
@@ -180,4 +183,71 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     }
 }
 
+BOOST_AUTO_TEST_CASE(SmartFeeEstimates)
+{
+    CBlockPolicyEstimator& feeEst = *Assert(m_node.fee_estimator);
+    CTxMemPool& mpool = *Assert(m_node.mempool);
+    LOCK2(cs_main, mpool.cs);
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig = CScript() << OP_TRUE;
+    tx.vout.resize(1);
+    const CAmount fee{10000};
+    const CFeeRate feerate(fee, GetVirtualTransactionSize(CTransaction(tx)));
+
+    // Estimates are read while blocks are processed, without any locks
+    std::atomic<bool> done{false};
+    std::atomic<int> bad_results{0};
+    std::thread reader([&] {
+        while (!done) {
+            for (int target = 1; target <= 25; target++) {
+                FeeCalculation calc;
+                const CFeeRate estimate{feeEst.estimateSmartFee(target, &calc, target % 2)};
+                if (calc.desiredTarget != target || calc.returnedTarget > std::max(target, 2) ||
+                    (estimate != CFeeRate(0) && calc.returnedTarget < 2)) {
+                    ++bad_results;
+                }
+            }
+        }
+    });
+
+    // Transactions at a single feerate, all mined in the next block
+    std::vector<CTransactionRef> block;
+    int blocknum = 0;
+    while (blocknum < 20) {
+        for (int k = 0; k < 4; k++) {
+            tx.vin[0].prevout.n = 100 * blocknum + k;
+            mpool.addUnchecked(entry.Fee(fee).Time(GetTime()).Height(blocknum).FromTx(tx));
+            block.push_back(mpool.get(tx.GetHash()));
+        }
+        mpool.removeForBlock(block, ++blocknum);
+        block.clear();
+    }
+    done = true;
+    reader.join();
+    BOOST_CHECK_EQUAL(bad_results, 0);
+
+    // Data was recorded for 19 blocks, so estimates go up to target 9
+    for (const bool conservative : {false, true}) {
+        FeeCalculation calc;
+        BOOST_CHECK(feeEst.estimateSmartFee(2, &calc, conservative) == feerate);
+        BOOST_CHECK_EQUAL(calc.desiredTarget, 2);
+        BOOST_CHECK_EQUAL(calc.returnedTarget, 2);
+
+        BOOST_CHECK(feeEst.estimateSmartFee(1, &calc, conservative) == feerate);
+        BOOST_CHECK_EQUAL(calc.desiredTarget, 1);
+        BOOST_CHECK_EQUAL(calc.returnedTarget, 2);
+
+        BOOST_CHECK(feeEst.estimateSmartFee(1000, &calc, conservative) == feeEst.estimateSmartFee(9, nullptr, conservative));
+        BOOST_CHECK_EQUAL(calc.desiredTarget, 1000);
+        BOOST_CHECK_EQUAL(calc.returnedTarget, 9);
+
+        BOOST_CHECK(feeEst.estimateSmartFee(0, &calc, conservative) == CFeeRate(0));
+        BOOST_CHECK(feeEst.estimateSmartFee(1009, &calc, conservative) == CFeeRate(0));
+        BOOST_CHECK_EQUAL(calc.returnedTarget, 1009);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -157,6 +157,65 @@ BOOST_AUTO_TEST_CASE(recv_until_terminator_limit)
     receiver.join();
 }
 
+BOOST_AUTO_TEST_CASE(wait_set)
+{
+    SockWaitSet wait_set;
+    Sock::EventsPerSock events_per_sock;
+
+    // Nothing to wait on.
+    BOOST_CHECK(!wait_set.WaitMany(0ms, events_per_sock));
+
+    int s[2];
+    CreateSocketPair(s);
+    auto sock0{std::make_shared<const Sock>(s[0])};
+    auto sock1{std::make_shared<const Sock>(s[1])};
+
+    // Both ends are writable, neither is readable.
+    events_per_sock.emplace(sock0, Sock::Events{Sock::RECV | Sock::SEND});
+    events_per_sock.emplace(sock1, Sock::Events{Sock::RECV});
+    BOOST_REQUIRE(wait_set.WaitMany(0ms, events_per_sock));
+    BOOST_CHECK_EQUAL(events_per_sock.at(sock0).occurred, Sock::SEND);
+    BOOST_CHECK_EQUAL(events_per_sock.at(sock1).occurred, 0);
+
+    // Readiness is reported for as long as the data is not consumed.
+    BOOST_REQUIRE_EQUAL(sock0->Send("a", 1, 0), 1);
+    for (int i = 0; i < 2; ++i) {
+        BOOST_REQUIRE(wait_set.WaitMany(1min, events_per_sock));
+        BOOST_CHECK_EQUAL(events_per_sock.at(sock1).occurred, Sock::RECV);
+    }
+
+    // Changing the requested events takes effect.
+    events_per_sock.at(sock0).requested = Sock::RECV;
+    events_per_sock.at(sock1).requested = Sock::SEND;
+    BOOST_REQUIRE(wait_set.WaitMany(0ms, events_per_sock));
+    BOOST_CHECK_EQUAL(events_per_sock.at(sock0).occurred, 0);
+    BOOST_CHECK_EQUAL(events_per_sock.at(sock1).occurred, Sock::SEND);
+
+    // A socket no longer passed in is not reported anymore.
+    events_per_sock.erase(sock1);
+    BOOST_REQUIRE(wait_set.WaitMany(0ms, events_per_sock));
+    BOOST_CHECK_EQUAL(events_per_sock.size(), 1U);
+    BOOST_CHECK_EQUAL(events_per_sock.at(sock0).occurred, 0);
+
+    // Closing the other end is reported as an error or as readability (EOF).
+    sock1.reset();
+    BOOST_REQUIRE(wait_set.WaitMany(1min, events_per_sock));
+    BOOST_CHECK(events_per_sock.at(sock0).occurred != 0);
+
+    // A new socket that gets the number of a closed one is picked up.
+    events_per_sock.clear();
+    sock0.reset();
+    CreateSocketPair(s);
+    auto sock2{std::make_shared<const Sock>(s[0])};
+    auto sock3{std::make_shared<const Sock>(s[1])};
+    events_per_sock.emplace(sock2, Sock::Events{Sock::RECV});
+    BOOST_REQUIRE(wait_set.WaitMany(0ms, events_per_sock));
+    BOOST_CHECK_EQUAL(events_per_sock.at(sock2).occurred, 0);
+    BOOST_REQUIRE_EQUAL(sock3->Send("b", 1, 0), 1);
+    BOOST_REQUIRE(wait_set.WaitMany(1min, events_per_sock));
+    BOOST_CHECK_EQUAL(events_per_sock.at(sock2).occurred, Sock::RECV);
+}
+
 #endif /* WIN32 */
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/util/setup_common.h>
+#include <util/threadpool.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(threadpool_tests, BasicTestingSetup)
+
+static const int POOL_THREADS = 3;
+
+BOOST_AUTO_TEST_CASE(threadpool_inline_without_workers)
+{
+    ThreadPool pool{"test"};
+    BOOST_CHECK_EQUAL(pool.WorkersCount(), 0);
+    const auto caller{std::this_thread::get_id()};
+    auto future{pool.Submit([] { return std::this_thread::get_id(); })};
+    BOOST_CHECK(future.get() == caller);
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_runs_all_tasks)
+{
+    ThreadPool pool{"test"};
+    pool.Start(POOL_THREADS, SyscallSandboxPolicy::VALIDATION_PREFETCH);
+    BOOST_CHECK_EQUAL(pool.WorkersCount(), POOL_THREADS);
+
+    std::atomic<int> sum{0};
+    std::vector<std::future<int>> futures;
+    for (int i = 1; i <= 1000; ++i) {
+        futures.push_back(pool.Submit([&sum, i] { sum += i; return i; }));
+    }
+    int total{0};
+    for (auto& future : futures) total += future.get();
+    BOOST_CHECK_EQUAL(total, 500500);
+    BOOST_CHECK_EQUAL(sum, 500500);
+
+    // Exceptions are passed on to the caller through the future.
+    auto failing{pool.Submit([]() -> int { throw std::runtime_error("fail"); })};
+    BOOST_CHECK_THROW(failing.get(), std::runtime_error);
+
+    pool.Stop();
+    BOOST_CHECK_EQUAL(pool.WorkersCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_stop_drains_queue)
+{
+    ThreadPool pool{"test"};
+    pool.Start(1, SyscallSandboxPolicy::VALIDATION_PREFETCH);
+
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::atomic<int> done{0};
+    // Block the only worker so the remaining tasks are still queued on Stop().
+    pool.Submit([released] { released.wait(); });
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 10; ++i) {
+        futures.push_back(pool.Submit([&done] { ++done; }));
+    }
+    std::thread stopper{[&pool] { pool.Stop(); }};
+    release.set_value();
+    stopper.join();
+    BOOST_CHECK_EQUAL(done, 10);
+    for (auto& future : futures) future.get();
+
+    // The pool can be restarted after being stopped.
+    pool.Start(POOL_THREADS, SyscallSandboxPolicy::VALIDATION_PREFETCH);
+    BOOST_CHECK_EQUAL(pool.Submit([] { return 42; }).get(), 42);
+    pool.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -342,6 +342,85 @@ BOOST_FIXTURE_TEST_CASE(package_submission_tests, TestChain100Setup)
 
 // Tests for packages containing transactions that have same-txid-different-witness equivalents in
 // the mempool.
+BOOST_FIXTURE_TEST_CASE(package_batch_submission_tests, TestChain100Setup)
+{
+    // Mine blocks to mature coinbases.
+    mineBlocks(5);
+    LOCK(cs_main);
+    unsigned int expected_pool_size = m_node.mempool->size();
+    CKey parent_key;
+    parent_key.MakeNewKey(true);
+    CScript parent_locking_script = GetScriptForDestination(PKHash(parent_key.GetPubKey()));
+    CKey child_key;
+    child_key.MakeNewKey(true);
+    CScript child_locking_script = GetScriptForDestination(PKHash(child_key.GetPubKey()));
+
+    // Create a parent and child spending the coinbase at index i, with the parent paying parent_fee.
+    const auto make_package = [&](size_t i, CAmount parent_fee) {
+        auto mtx_parent = CreateValidMempoolTransaction(/*input_transaction=*/m_coinbase_txns[i], /*input_vout=*/0,
+                                                        /*input_height=*/0, /*input_signing_key=*/coinbaseKey,
+                                                        /*output_destination=*/parent_locking_script,
+                                                        /*output_amount=*/CAmount(50 * COIN) - parent_fee, /*submit=*/false);
+        CTransactionRef tx_parent = MakeTransactionRef(mtx_parent);
+        auto mtx_child = CreateValidMempoolTransaction(/*input_transaction=*/tx_parent, /*input_vout=*/0,
+                                                       /*input_height=*/106, /*input_signing_key=*/parent_key,
+                                                       /*output_destination=*/child_locking_script,
+                                                       /*output_amount=*/CAmount(48 * COIN) - parent_fee, /*submit=*/false);
+        return Package{tx_parent, MakeTransactionRef(mtx_child)};
+    };
+
+    // Packages are validated in order, each one against the mempool left by the previous ones.
+    {
+        const Package package1{make_package(0, COIN)};
+        const Package package2{make_package(1, COIN)};
+        // Spends the same coinbase as package1, but pays less fees than it.
+        const Package package_conflict{make_package(0, COIN / 2)};
+        const auto results = ProcessNewPackages(m_node.chainman->ActiveChainstate(), *m_node.mempool,
+                                                {package1, package2, package1, package_conflict}, /*test_accept=*/false);
+        expected_pool_size += 4;
+        BOOST_CHECK_EQUAL(results.size(), 4U);
+        BOOST_CHECK_EQUAL(m_node.mempool->size(), expected_pool_size);
+        for (size_t i{0}; i < 2; ++i) {
+            BOOST_CHECK_MESSAGE(results[i].m_state.IsValid(),
+                                "Package validation unexpectedly failed: " << results[i].m_state.GetRejectReason());
+            for (const auto& tx : (i == 0 ? package1 : package2)) {
+                BOOST_CHECK(m_node.mempool->exists(GenTxid::Wtxid(tx->GetWitnessHash())));
+                auto it = results[i].m_tx_results.find(tx->GetWitnessHash());
+                BOOST_CHECK(it != results[i].m_tx_results.end());
+                BOOST_CHECK(it->second.m_result_type == MempoolAcceptResult::ResultType::VALID);
+            }
+        }
+        // Resubmitting a package within the same batch is deduplicated against the mempool.
+        BOOST_CHECK(results[2].m_state.IsValid());
+        for (const auto& tx : package1) {
+            auto it = results[2].m_tx_results.find(tx->GetWitnessHash());
+            BOOST_CHECK(it != results[2].m_tx_results.end());
+            BOOST_CHECK(it->second.m_result_type == MempoolAcceptResult::ResultType::MEMPOOL_ENTRY);
+        }
+        // The coinbase output is still cached as unspent, but the conflict with package1 is found.
+        BOOST_CHECK(results[3].m_state.IsInvalid());
+        for (const auto& tx : package_conflict) {
+            BOOST_CHECK(!m_node.mempool->exists(GenTxid::Txid(tx->GetHash())));
+        }
+    }
+
+    // Outputs of a test-accepted package are not available to the packages after it.
+    {
+        const Package package{make_package(2, COIN)};
+        const auto results = ProcessNewPackages(m_node.chainman->ActiveChainstate(), *m_node.mempool,
+                                                {package, {package.back()}}, /*test_accept=*/true);
+        BOOST_CHECK_EQUAL(results.size(), 2U);
+        BOOST_CHECK_EQUAL(m_node.mempool->size(), expected_pool_size);
+        BOOST_CHECK_MESSAGE(results[0].m_state.IsValid(),
+                            "Package validation unexpectedly failed: " << results[0].m_state.GetRejectReason());
+        BOOST_CHECK_EQUAL(results[0].m_tx_results.size(), package.size());
+        BOOST_CHECK(results[1].m_state.IsInvalid());
+        auto it_child = results[1].m_tx_results.find(package.back()->GetWitnessHash());
+        BOOST_CHECK(it_child != results[1].m_tx_results.end());
+        BOOST_CHECK_EQUAL(it_child->second.m_state.GetResult(), TxValidationResult::TX_MISSING_INPUTS);
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(package_witness_swap_tests, TestChain100Setup)
 {
     // Mine blocks to mature coinbases.
@@ -14,6 +14,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+
 
 BOOST_AUTO_TEST_SUITE(txvalidation_tests)
 
@@ -49,4 +51,40 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup)
     BOOST_CHECK_EQUAL(result.m_state.GetRejectReason(), "coinbase");
     BOOST_CHECK(result.m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
 }
+
+/**
+ * Ensure that pre-checking transactions does not decide whether they are accepted.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_precheck, TestChain100Setup)
+{
+    const CScript spk{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction valid_tx{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, spk, 49 * COIN, /*submit=*/false)};
+    // Changing the output after signing invalidates the signature
+    CMutableTransaction invalid_tx{valid_tx};
+    invalid_tx.vout[0].nValue = 48 * COIN;
+    CMutableTransaction orphan_tx{valid_tx};
+    orphan_tx.vin[0].prevout.hash = InsecureRand256();
+
+    LOCK(cs_main);
+    // Nothing is pre-checked without worker threads
+    BOOST_CHECK(!m_node.chainman->PreCheckTransaction(MakeTransactionRef(valid_tx)));
+
+    StartTxPreCheckWorkerThreads(2);
+    BOOST_CHECK(!m_node.chainman->PreCheckTransaction(MakeTransactionRef(orphan_tx)));
+    std::atomic<int> checked{0};
+    auto valid_check{m_node.chainman->PreCheckTransaction(MakeTransactionRef(valid_tx), [&] { ++checked; })};
+    auto invalid_check{m_node.chainman->PreCheckTransaction(MakeTransactionRef(invalid_tx), [&] { ++checked; })};
+    BOOST_REQUIRE(valid_check && invalid_check);
+    valid_check->wait();
+    invalid_check->wait();
+    StopTxPreCheckWorkerThreads();
+    BOOST_CHECK_EQUAL(checked, 2);
+
+    const MempoolAcceptResult invalid_result{m_node.chainman->ProcessTransaction(MakeTransactionRef(invalid_tx))};
+    BOOST_CHECK(invalid_result.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK(invalid_result.m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
+    const MempoolAcceptResult valid_result{m_node.chainman->ProcessTransaction(MakeTransactionRef(valid_tx))};
+    BOOST_CHECK(valid_result.m_result_type == MempoolAcceptResult::ResultType::VALID);
+    BOOST_CHECK(m_node.mempool->exists(GenTxid::Txid(valid_tx.GetHash())));
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -202,12 +202,18 @@ ChainTestingSetup::ChainTestingSetup(const std::string& chainName, const std::ve
     constexpr int script_check_threads = 2;
     StartScriptCheckWorkerThreads(script_check_threads);
     g_parallel_script_checks = true;
+
+    constexpr int prefetch_threads = 2;
+    StartCoinsPrefetchWorkerThreads(prefetch_threads);
+    StartBlockReadAheadThread();
 }
 
 ChainTestingSetup::~ChainTestingSetup()
 {
     if (m_node.scheduler) m_node.scheduler->stop();
     StopScriptCheckWorkerThreads();
+    StopCoinsPrefetchWorkerThreads();
+    StopBlockReadAheadThread();
     GetMainSignals().FlushBackgroundCallbacks();
     GetMainSignals().UnregisterBackgroundSignalScheduler();
     m_node.connman.reset();
@@ -148,4 +148,50 @@ BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup)
     BOOST_CHECK_EQUAL(curr_tip, ::g_best_block);
 }
 
+//! Test that blocks reconnected from disk, which are read ahead while the
+//! previous block is connected, bring the chain back to the same tip.
+BOOST_FIXTURE_TEST_CASE(chainstate_reconnect_read_ahead, TestChain100Setup)
+{
+    Chainstate& chainstate{Assert(m_node.chainman)->ActiveChainstate()};
+    CBlockIndex* tip{WITH_LOCK(::cs_main, return chainstate.m_chain.Tip())};
+    CBlockIndex* fork{tip->GetAncestor(tip->nHeight - 10)};
+
+    BlockValidationState state;
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, tip->GetAncestor(fork->nHeight + 1)));
+    BOOST_CHECK_EQUAL(WITH_LOCK(::cs_main, return chainstate.m_chain.Tip()), fork);
+
+    WITH_LOCK(::cs_main, chainstate.ResetBlockFailureFlags(tip->GetAncestor(fork->nHeight + 1)));
+    BOOST_REQUIRE(chainstate.ActivateBestChain(state));
+    BOOST_CHECK(state.IsValid());
+    LOCK(::cs_main);
+    BOOST_CHECK_EQUAL(chainstate.m_chain.Tip(), tip);
+    BOOST_CHECK_EQUAL(chainstate.CoinsTip().GetBestBlock(), tip->GetBlockHash());
+}
+
+//! Verify the chain at every check level while the block reads run on the VerifyDB worker threads.
+BOOST_FIXTURE_TEST_CASE(chainstate_verifydb, TestChain100Setup)
+{
+    Chainstate& chainstate{Assert(m_node.chainman)->ActiveChainstate()};
+    const Consensus::Params& consensus_params{Params().GetConsensus()};
+    LOCK(::cs_main);
+    CBlockIndex* tip{chainstate.m_chain.Tip()};
+
+    for (int check_level = 0; check_level <= 4; ++check_level) {
+        for (int check_depth : {0, 1, 10}) {
+            BOOST_CHECK(CVerifyDB().VerifyDB(chainstate, consensus_params, chainstate.CoinsTip(), check_level, check_depth));
+            BOOST_CHECK_EQUAL(chainstate.m_chain.Tip(), tip);
+            BOOST_CHECK_EQUAL(chainstate.CoinsTip().GetBestBlock(), tip->GetBlockHash());
+        }
+    }
+
+    // Point a block at the wrong data on disk: the read check must fail.
+    CBlockIndex* block{tip->GetAncestor(tip->nHeight - 5)};
+    const unsigned int data_pos{block->nDataPos};
+    block->nDataPos = tip->nDataPos;
+    BOOST_CHECK(!CVerifyDB().VerifyDB(chainstate, consensus_params, chainstate.CoinsTip(), /*nCheckLevel=*/0, /*nCheckDepth=*/10));
+    BOOST_CHECK(CVerifyDB().VerifyDB(chainstate, consensus_params, chainstate.CoinsTip(), /*nCheckLevel=*/0, /*nCheckDepth=*/5));
+    block->nDataPos = data_pos;
+    BOOST_CHECK(CVerifyDB().VerifyDB(chainstate, consensus_params, chainstate.CoinsTip(), /*nCheckLevel=*/4, /*nCheckDepth=*/10));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
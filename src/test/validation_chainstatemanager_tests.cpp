@@ -3,9 +3,11 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 //
 #include <chainparams.h>
+#include <coins.h>
 #include <consensus/validation.h>
 #include <node/utxo_snapshot.h>
 #include <random.h>
+#include <script/script.h>
 #include <rpc/blockchain.h>
 #include <sync.h>
 #include <test/util/chainstate.h>
@@ -21,6 +23,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+using node::SnapshotChunkHeader;
 using node::SnapshotMetadata;
 
 BOOST_FIXTURE_TEST_SUITE(validation_chainstatemanager_tests, ChainTestingSetup)
@@ -220,14 +223,11 @@ struct SnapshotTestSetup : TestChain100Setup {
         // Should not load malleated snapshots
         BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
             this, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
-                // A UTXO is missing but count is correct
-                metadata.m_coins_count -= 1;
-
-                COutPoint outpoint;
-                Coin coin;
-
-                auto_infile >> outpoint;
-                auto_infile >> coin;
+                // A chunk of UTXOs is missing but count is correct
+                SnapshotChunkHeader header;
+                auto_infile >> header;
+                auto_infile.ignore(header.m_size);
+                metadata.m_coins_count -= header.m_coins_count;
         }));
 
         BOOST_CHECK(!node::FindSnapshotChainstateDir());
@@ -391,6 +391,49 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot, SnapshotTestSetup)
     this->SetupSnapshot();
 }
 
+//! Test that snapshot chunks are only accepted when intact and sorted.
+BOOST_AUTO_TEST_CASE(chainstatemanager_snapshot_chunk)
+{
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    for (uint32_t n = 0; n < 3; ++n) {
+        coins.emplace_back(COutPoint{uint256::ONE, n}, Coin{CTxOut{COIN, CScript{} << OP_TRUE}, /*nHeightIn=*/10, /*fCoinBaseIn=*/false});
+    }
+    coins.emplace_back(COutPoint{uint256S("02"), 0}, Coin{CTxOut{COIN, CScript{} << OP_TRUE}, /*nHeightIn=*/20, /*fCoinBaseIn=*/true});
+
+    const node::SnapshotChunk chunk{node::SerializeSnapshotChunk(coins)};
+    BOOST_CHECK_EQUAL(chunk.header.m_coins_count, coins.size());
+    BOOST_CHECK_EQUAL(chunk.header.m_size, chunk.data.size());
+
+    const auto parsed{node::ParseSnapshotChunk(chunk.header, chunk.data, /*base_height=*/20)};
+    BOOST_REQUIRE(parsed);
+    BOOST_REQUIRE_EQUAL(parsed->txs.size(), 2U);
+    BOOST_CHECK(parsed->txs[0].first == uint256::ONE);
+    BOOST_CHECK_EQUAL(parsed->txs[0].second.size(), 3U);
+    const Coin& coin{parsed->txs[1].second.at(0)};
+    BOOST_CHECK(coin.out == coins.back().second.out);
+    BOOST_CHECK_EQUAL(coin.nHeight, 20U);
+    BOOST_CHECK(coin.IsCoinBase());
+    BOOST_CHECK(!parsed->hash_data.empty());
+
+    // Coins from after the snapshot base
+    BOOST_CHECK(!node::ParseSnapshotChunk(chunk.header, chunk.data, /*base_height=*/19));
+
+    // Corrupted data
+    std::vector<unsigned char> data{chunk.data};
+    data.back() ^= 1;
+    BOOST_CHECK(!node::ParseSnapshotChunk(chunk.header, data, /*base_height=*/20));
+
+    // Fewer coins than the header says
+    node::SnapshotChunkHeader header{chunk.header};
+    ++header.m_coins_count;
+    BOOST_CHECK(!node::ParseSnapshotChunk(header, chunk.data, /*base_height=*/20));
+
+    // Unsorted coins
+    std::swap(coins.front(), coins.back());
+    const node::SnapshotChunk unsorted{node::SerializeSnapshotChunk(coins)};
+    BOOST_CHECK(!node::ParseSnapshotChunk(unsorted.header, unsorted.data, /*base_height=*/20));
+}
+
 //! Test LoadBlockIndex behavior when multiple chainstates are in use.
 //!
 //! - First, verify that setBlockIndexCandidates is as expected when using a single,
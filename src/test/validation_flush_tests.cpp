@@ -54,35 +54,19 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
         chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/0),
         CoinsCacheSizeState::OK);
 
-    // If the initial memory allocations of cacheCoins don't match these common
-    // cases, we can't really continue to make assertions about memory usage.
-    // End the test early.
-    if (view.DynamicMemoryUsage() != 32 && view.DynamicMemoryUsage() != 16) {
-        // Add a bunch of coins to see that we at least flip over to CRITICAL.
-
-        for (int i{0}; i < 1000; ++i) {
-            COutPoint res = add_coin(view);
-            BOOST_CHECK_EQUAL(view.AccessCoin(res).DynamicMemoryUsage(), COIN_SIZE);
-        }
-
-        BOOST_CHECK_EQUAL(
-            chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/0),
-            CoinsCacheSizeState::CRITICAL);
-
-        BOOST_TEST_MESSAGE("Exiting cache flush tests early due to unsupported arch");
-        return;
-    }
-
+    // The cacheCoins map does not allocate any memory until the first coin is added.
     print_view_mem_usage(view);
-    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), is_64_bit ? 32U : 16U);
+    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), 0U);
+    BOOST_CHECK(chainstate.CoinsWriter().Sync());
+    BOOST_CHECK_EQUAL(chainstate.CoinsWriter().PendingMemoryUsage(), 0U);
 
-    // We should be able to add COINS_UNTIL_CRITICAL coins to the cache before going CRITICAL.
+    // We should be able to add COINS_UNTIL_LARGE coins to the cache before going LARGE.
     // This is contingent not only on the dynamic memory usage of the Coins
-    // that we're adding (COIN_SIZE bytes per), but also on how much memory the
-    // cacheCoins (unordered_map) preallocates.
-    constexpr int COINS_UNTIL_CRITICAL{3};
+    // that we're adding (COIN_SIZE bytes per), but also on the size of the
+    // table that cacheCoins (FlatHashMap) allocates for its entries.
+    constexpr int COINS_UNTIL_LARGE{is_64_bit ? 1 : 3};
 
-    for (int i{0}; i < COINS_UNTIL_CRITICAL; ++i) {
+    for (int i{0}; i < COINS_UNTIL_LARGE; ++i) {
         COutPoint res = add_coin(view);
         print_view_mem_usage(view);
         BOOST_CHECK_EQUAL(view.AccessCoin(res).DynamicMemoryUsage(), COIN_SIZE);
@@ -118,10 +102,16 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
             CoinsCacheSizeState::OK);
     }
 
-    // Adding another coin with the additional mempool room will put us >90%
-    // but not yet critical.
-    add_coin(view);
-    print_view_mem_usage(view);
+    // Adding more coins with the additional mempool room will eventually put
+    // us >90% but not yet critical.
+    for (int i{0}; i < 20; ++i) {
+        add_coin(view);
+        print_view_mem_usage(view);
+        if (chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, /*max_mempool_size_bytes=*/1 << 10) !=
+            CoinsCacheSizeState::OK) {
+            break;
+        }
+    }
 
     // Only perform these checks on 64 bit hosts; I haven't done the math for 32.
     if (is_64_bit) {
@@ -142,8 +132,8 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
             CoinsCacheSizeState::OK);
     }
 
-    // Flushing the view doesn't take us back to OK because cacheCoins has
-    // preallocated memory that doesn't get reclaimed even after flush.
+    // Flushing the view takes us back to OK once the coins are written to
+    // disk, as cacheCoins releases its table when it is cleared.
 
     BOOST_CHECK_EQUAL(
         chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, 0),
@@ -152,10 +142,13 @@ BOOST_AUTO_TEST_CASE(getcoinscachesizestate)
     view.SetBestBlock(InsecureRand256());
     BOOST_CHECK(view.Flush());
     print_view_mem_usage(view);
+    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), 0U);
+    BOOST_CHECK(chainstate.CoinsWriter().Sync());
+    BOOST_CHECK_EQUAL(chainstate.CoinsWriter().PendingMemoryUsage(), 0U);
 
     BOOST_CHECK_EQUAL(
         chainstate.GetCoinsCacheSizeState(MAX_COINS_CACHE_BYTES, 0),
-        CoinsCacheSizeState::CRITICAL);
+        CoinsCacheSizeState::OK);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -10,12 +10,18 @@
 #include <random.h>
 #include <shutdown.h>
 #include <uint256.h>
+#include <util/syscall_sandbox.h>
 #include <util/system.h>
+#include <util/thread.h>
+#include <util/time.h>
+#include <util/trace.h>
 #include <util/translation.h>
 #include <util/vector.h>
 
 #include <stdint.h>
 
+#include <type_traits>
+
 static constexpr uint8_t DB_COIN{'C'};
 static constexpr uint8_t DB_BLOCK_FILES{'f'};
 static constexpr uint8_t DB_BLOCK_INDEX{'b'};
@@ -25,6 +31,7 @@ static constexpr uint8_t DB_HEAD_BLOCKS{'H'};
 static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
+static constexpr uint8_t DB_BLOCK_INDEX_SNAPSHOT{'S'};
 
 // Keys used in previous version that might still be found in the DB:
 static constexpr uint8_t DB_COINS{'c'};
@@ -112,6 +119,15 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+    return WriteCoins(mapCoins, hashBlock);
+}
+
+bool CCoinsViewDB::BatchWrite(const CCoinsMap& mapCoins, const uint256& hashBlock) {
+    return WriteCoins(mapCoins, hashBlock);
+}
+
+template <typename Map>
+bool CCoinsViewDB::WriteCoins(Map& mapCoins, const uint256& hashBlock) {
     CDBBatch batch(*m_db);
     size_t count = 0;
     size_t changed = 0;
@@ -136,7 +152,7 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
     batch.Erase(DB_BEST_BLOCK);
     batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
 
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+    for (auto it = mapCoins.begin(); it != mapCoins.end();) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent())
@@ -146,8 +162,11 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
             changed++;
         }
         count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
+        if constexpr (std::is_const_v<Map>) {
+            ++it;
+        } else {
+            it = mapCoins.erase(it);
+        }
         if (batch.SizeEstimate() > batch_size) {
             LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
             m_db->WriteBatch(batch);
@@ -177,6 +196,142 @@ size_t CCoinsViewDB::EstimateSize() const
     return m_db->EstimateSize(DB_COIN, uint8_t(DB_COIN + 1));
 }
 
+CCoinsViewBackgroundWriter::CCoinsViewBackgroundWriter(CCoinsViewDB& db) : CCoinsViewBacked(&db), m_db(db)
+{
+    m_thread = std::thread(&util::TraceThread, "coinsflush", [this] { ThreadWrite(); });
+}
+
+CCoinsViewBackgroundWriter::~CCoinsViewBackgroundWriter()
+{
+    WITH_LOCK(m_mutex, m_request_stop = true);
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+void CCoinsViewBackgroundWriter::ThreadWrite()
+{
+    SetSyscallSandboxPolicy(SyscallSandboxPolicy::VALIDATION_COINS_FLUSH);
+    while (true) {
+        std::shared_ptr<const CCoinsMap> pending;
+        uint256 block;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_request_stop || (m_pending && !m_failed); });
+            // Finish the pending write before exiting.
+            if (!m_pending || m_failed) return;
+            pending = m_pending;
+            block = m_pending_block;
+        }
+
+        const auto time_start{SteadyClock::now()};
+        bool ok{false};
+        try {
+            ok = m_db.BatchWrite(*pending, block);
+        } catch (const std::runtime_error& e) {
+            LogPrintf("Error writing to coin database: %s\n", e.what());
+        }
+        const auto duration{SteadyClock::now() - time_start};
+        LogPrint(BCLog::BENCH, "Wrote %u coins to coin database in the background: %.2fms\n",
+                 pending->size(), Ticks<MillisecondsDouble>(duration));
+        TRACE3(utxocache, write,
+               (int64_t)Ticks<std::chrono::microseconds>(duration),
+               (uint64_t)pending->size(),
+               ok);
+
+        {
+            LOCK(m_mutex);
+            if (ok) {
+                m_pending.reset();
+                m_pending_usage = 0;
+            } else {
+                m_failed = true;
+            }
+        }
+        m_cv.notify_all();
+    }
+}
+
+bool CCoinsViewBackgroundWriter::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    if (const auto pending{WITH_LOCK(m_mutex, return m_pending)}) {
+        const auto it{pending->find(outpoint)};
+        if (it != pending->end()) {
+            coin = it->second.coin;
+            return !coin.IsSpent();
+        }
+    }
+    // Entries that are not pending are unaffected by a write in progress.
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewBackgroundWriter::HaveCoin(const COutPoint& outpoint) const
+{
+    Coin coin;
+    return GetCoin(outpoint, coin);
+}
+
+uint256 CCoinsViewBackgroundWriter::GetBestBlock() const
+{
+    {
+        LOCK(m_mutex);
+        if (m_pending) return m_pending_block;
+    }
+    return base->GetBestBlock();
+}
+
+bool CCoinsViewBackgroundWriter::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
+{
+    if (!Sync()) return false;
+
+    auto pending{std::make_shared<CCoinsMap>()};
+    size_t dirty{0};
+    for (const auto& [outpoint, entry] : mapCoins) {
+        if (entry.flags & CCoinsCacheEntry::DIRTY) ++dirty;
+    }
+    pending->reserve(dirty);
+    size_t coins_usage{0};
+    for (auto it = mapCoins.begin(); it != mapCoins.end(); it = mapCoins.erase(it)) {
+        // Entries that are not dirty are already in the database.
+        if (!(it->second.flags & CCoinsCacheEntry::DIRTY)) continue;
+        coins_usage += it->second.coin.DynamicMemoryUsage();
+        pending->try_emplace(it->first, std::move(it->second));
+    }
+
+    {
+        LOCK(m_mutex);
+        m_pending_usage = memusage::DynamicUsage(*pending) + coins_usage;
+        m_pending = std::move(pending);
+        m_pending_block = hashBlock;
+    }
+    m_cv.notify_all();
+    return true;
+}
+
+std::unique_ptr<CCoinsViewCursor> CCoinsViewBackgroundWriter::Cursor() const
+{
+    Sync();
+    return base->Cursor();
+}
+
+bool CCoinsViewBackgroundWriter::Sync() const
+{
+    WAIT_LOCK(m_mutex, lock);
+    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_pending || m_failed; });
+    return !m_failed;
+}
+
+bool CCoinsViewBackgroundWriter::IsWriting() const
+{
+    LOCK(m_mutex);
+    return m_pending != nullptr;
+}
+
+size_t CCoinsViewBackgroundWriter::PendingMemoryUsage() const
+{
+    LOCK(m_mutex);
+    return m_pending_usage;
+}
+
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(gArgs.GetDataDirNet() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
 }
 
@@ -296,6 +451,21 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+bool CBlockTreeDB::WriteBlockIndexSnapshot(const BlockIndexSnapshotInfo& info)
+{
+    return Write(DB_BLOCK_INDEX_SNAPSHOT, info, /*fSync=*/true);
+}
+
+bool CBlockTreeDB::ReadBlockIndexSnapshot(BlockIndexSnapshotInfo& info)
+{
+    return Read(DB_BLOCK_INDEX_SNAPSHOT, info);
+}
+
+bool CBlockTreeDB::EraseBlockIndexSnapshot()
+{
+    return Erase(DB_BLOCK_INDEX_SNAPSHOT, /*fSync=*/true);
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
     AssertLockHeld(::cs_main);
@@ -10,16 +10,19 @@
 #include <dbwrapper.h>
 #include <sync.h>
 #include <fs.h>
+#include <serialize.h>
+#include <uint256.h>
 
+#include <condition_variable>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 class CBlockFileInfo;
 class CBlockIndex;
-class uint256;
 namespace Consensus {
 struct Params;
 };
@@ -54,6 +57,12 @@ protected:
     std::unique_ptr<CDBWrapper> m_db;
     fs::path m_ldb_path;
     bool m_is_memory;
+
+private:
+    //! Write the dirty entries of mapCoins, erasing all entries from it unless it is const.
+    template <typename Map>
+    bool WriteCoins(Map& mapCoins, const uint256& hashBlock);
+
 public:
     /**
      * @param[in] ldb_path    Location in the filesystem where leveldb data will be stored.
@@ -65,6 +74,8 @@ public:
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
+    //! Like BatchWrite(), but leaves mapCoins unmodified, so it can be read concurrently.
+    bool BatchWrite(const CCoinsMap& mapCoins, const uint256& hashBlock);
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
 
     //! Whether an unsupported database format is used.
@@ -78,7 +89,80 @@ public:
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
 };
 
+/**
+ * CCoinsView on top of the coin database that writes flushed coins to it on a
+ * background thread, so that flushing a large cache does not stall validation
+ * for as long as the database write takes.
+ *
+ * BatchWrite() moves the dirty entries into a pending map and returns. They
+ * are written by CCoinsViewDB::BatchWrite() in batches of -dbbatchsize bytes
+ * between the usual DB_HEAD_BLOCKS markers, so a crash during a background
+ * write is recovered from like any interrupted flush. Until the write is
+ * complete, reads are served from the pending map first, as the database may
+ * only be partially updated. A new BatchWrite() waits for the previous write.
+ */
+class CCoinsViewBackgroundWriter final : public CCoinsViewBacked
+{
+private:
+    CCoinsViewDB& m_db;
+
+    mutable Mutex m_mutex;
+    //! Signalled when a write is queued or completed, and on shutdown.
+    mutable std::condition_variable m_cv;
+    //! Coins being written, or nullptr if there are none. Not modified while shared.
+    std::shared_ptr<const CCoinsMap> m_pending GUARDED_BY(m_mutex);
+    uint256 m_pending_block GUARDED_BY(m_mutex);
+    size_t m_pending_usage GUARDED_BY(m_mutex){0};
+    //! Set when a write failed. The pending coins are kept, so reads remain correct.
+    bool m_failed GUARDED_BY(m_mutex){false};
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+
+    std::thread m_thread;
+
+    void ThreadWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+public:
+    explicit CCoinsViewBackgroundWriter(CCoinsViewDB& db);
+    //! Finishes the pending write, if any.
+    ~CCoinsViewBackgroundWriter();
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool HaveCoin(const COutPoint& outpoint) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    uint256 GetBestBlock() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::unique_ptr<CCoinsViewCursor> Cursor() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Wait until the coins passed to BatchWrite() are written to the database.
+     *
+     * @returns false if writing them failed
+     */
+    bool Sync() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    //! Whether coins passed to BatchWrite() have yet to be written.
+    bool IsWriting() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    //! Memory used by the coins waiting to be written.
+    size_t PendingMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 /** Access to the block database (blocks/index/) */
+/**
+ * Identifies the block index snapshot file written from the contents of the
+ * block tree database, together with the state of the last block file at
+ * that point, which is checked again before the snapshot is used.
+ */
+struct BlockIndexSnapshotInfo {
+    //! Hash of the snapshot file contents
+    uint256 hash;
+    int last_block_file{0};
+    unsigned int last_block_file_size{0};
+    unsigned int last_undo_file_size{0};
+
+    SERIALIZE_METHODS(BlockIndexSnapshotInfo, obj)
+    {
+        READWRITE(obj.hash, obj.last_block_file, obj.last_block_file_size, obj.last_undo_file_size);
+    }
+};
+
 class CBlockTreeDB : public CDBWrapper
 {
 public:
@@ -91,6 +175,9 @@ public:
     void ReadReindexing(bool &fReindexing);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    bool WriteBlockIndexSnapshot(const BlockIndexSnapshotInfo& info);
+    bool ReadBlockIndexSnapshot(BlockIndexSnapshotInfo& info);
+    bool EraseBlockIndexSnapshot();
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 };
@@ -21,8 +21,10 @@
 #include <util/time.h>
 #include <validationinterface.h>
 
+#include <algorithm>
 #include <cmath>
 #include <optional>
+#include <queue>
 
 bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
 {
@@ -41,6 +43,113 @@ bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
     return true;
 }
 
+static TxMempoolInfo GetInfo(CTxMemPool::indexed_transaction_set::const_iterator it) {
+    return TxMempoolInfo{it->GetSharedTx(), it->GetTime(), it->GetFee(), it->GetTxSize(), it->GetModifiedFee() - it->GetFee()};
+}
+
+TxMempoolSnapshot::TxMempoolSnapshot()
+{
+    for (auto* shards : {&m_by_txid, &m_by_wtxid}) {
+        for (Shard& shard : *shards) {
+            LOCK(shard.m_mutex);
+            shard.m_published = std::make_shared<const Entries>();
+        }
+    }
+}
+
+static bool CompareEntryHash(const std::pair<uint256, TxMempoolInfo>& entry, const uint256& hash)
+{
+    return entry.first < hash;
+}
+
+std::optional<TxMempoolInfo> TxMempoolSnapshot::Get(const GenTxid& gtxid) const
+{
+    const Shard& shard{GetShard(gtxid.IsWtxid() ? m_by_wtxid : m_by_txid, gtxid.GetHash())};
+    const std::shared_ptr<const Entries> entries{WITH_LOCK(shard.m_mutex, return shard.m_published)};
+    const auto it{std::lower_bound(entries->begin(), entries->end(), gtxid.GetHash(), CompareEntryHash)};
+    if (it == entries->end() || it->first != gtxid.GetHash()) return std::nullopt;
+    return it->second;
+}
+
+std::vector<TxMempoolInfo> TxMempoolSnapshot::GetAll() const
+{
+    std::vector<TxMempoolInfo> infos;
+    for (const Shard& shard : m_by_txid) {
+        const std::shared_ptr<const Entries> entries{WITH_LOCK(shard.m_mutex, return shard.m_published)};
+        for (const auto& [txid, info] : *entries) {
+            infos.push_back(info);
+        }
+    }
+    return infos;
+}
+
+TxMempoolSnapshot::Entries& TxMempoolSnapshot::Stage(Shard& shard)
+{
+    if (!shard.m_staged) {
+        shard.m_staged = std::make_shared<Entries>(*WITH_LOCK(shard.m_mutex, return shard.m_published));
+        m_dirty.push_back(&shard);
+    }
+    return *shard.m_staged;
+}
+
+void TxMempoolSnapshot::Add(const TxMempoolInfo& info)
+{
+    for (const auto& [shards, hash] : {std::pair{&m_by_txid, info.tx->GetHash()}, std::pair{&m_by_wtxid, info.tx->GetWitnessHash()}}) {
+        Entries& entries{Stage(GetShard(*shards, hash))};
+        entries.emplace(std::lower_bound(entries.begin(), entries.end(), hash, CompareEntryHash), hash, info);
+    }
+    ++m_size;
+}
+
+void TxMempoolSnapshot::Remove(const CTransaction& tx)
+{
+    for (const auto& [shards, hash] : {std::pair{&m_by_txid, tx.GetHash()}, std::pair{&m_by_wtxid, tx.GetWitnessHash()}}) {
+        Entries& entries{Stage(GetShard(*shards, hash))};
+        const auto it{std::lower_bound(entries.begin(), entries.end(), hash, CompareEntryHash)};
+        if (it != entries.end() && it->first == hash) entries.erase(it);
+    }
+    --m_size;
+}
+
+void TxMempoolSnapshot::SetFeeDelta(const CTransaction& tx, int64_t fee_delta)
+{
+    for (const auto& [shards, hash] : {std::pair{&m_by_txid, tx.GetHash()}, std::pair{&m_by_wtxid, tx.GetWitnessHash()}}) {
+        Entries& entries{Stage(GetShard(*shards, hash))};
+        const auto it{std::lower_bound(entries.begin(), entries.end(), hash, CompareEntryHash)};
+        if (it != entries.end() && it->first == hash) it->second.nFeeDelta = fee_delta;
+    }
+}
+
+void TxMempoolSnapshot::Publish()
+{
+    for (Shard* shard : m_dirty) {
+        std::shared_ptr<const Entries> staged{std::move(shard->m_staged)};
+        LOCK(shard->m_mutex);
+        shard->m_published.swap(staged);
+    }
+    m_dirty.clear();
+}
+
+void TxMempoolSnapshot::Clear()
+{
+    m_size = 0;
+    m_dirty.clear();
+    for (auto* shards : {&m_by_txid, &m_by_wtxid}) {
+        for (Shard& shard : *shards) {
+            shard.m_staged.reset();
+            LOCK(shard.m_mutex);
+            shard.m_published = std::make_shared<const Entries>();
+        }
+    }
+}
+
+size_t TxMempoolSnapshot::DynamicMemoryUsage() const
+{
+    // Each transaction has an entry in both indexes. The copies of shards that
+    // readers may still hold are not accounted for.
+    return 2 * m_size * sizeof(Entries::value_type);
+}
+
 CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& tx, CAmount fee,
                                  int64_t time, unsigned int entry_height,
                                  bool spends_coinbase, int64_t sigops_cost, LockPoints lp)
@@ -131,6 +240,7 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendan
 void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashesToUpdate)
 {
     AssertLockHeld(cs);
+    const SnapshotBatch snapshot_batch{*this};
     // For each entry in vHashesToUpdate, store the set of in-mempool, but not
     // in-vHashesToUpdate transactions, so that we don't have to recalculate
     // descendants when we come across a previously seen entry.
@@ -168,6 +278,9 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
                 if (!visited(childIter) && !setAlreadyIncluded.count(childHash)) {
                     UpdateChild(it, childIter, true);
                     UpdateParent(childIter, it, true);
+                    if (m_track_clusters && it->m_cluster != childIter->m_cluster) {
+                        MergeClusters(*it->m_cluster, *childIter->m_cluster);
+                    }
                 }
             }
         } // release epoch guard for UpdateForDescendants
@@ -423,6 +536,7 @@ CTxMemPool::CTxMemPool(const Options& opts)
       m_max_datacarrier_bytes{opts.max_datacarrier_bytes},
       m_require_standard{opts.require_standard},
       m_full_rbf{opts.full_rbf},
+      m_track_clusters{opts.track_clusters},
       m_limits{opts.limits}
 {
     _clear(); //lock free clear
@@ -449,6 +563,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     // Add to memory pool without checking anything.
     // Used by AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
+    const SnapshotBatch snapshot_batch{*this};
     indexed_transaction_set::iterator newit = mapTx.insert(entry).first;
 
     // Update transaction for any feeDelta created by PrioritiseTransaction
@@ -484,6 +599,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     }
     UpdateAncestorsOf(true, newit, setAncestors);
     UpdateEntryForAncestors(newit, setAncestors);
+    if (m_track_clusters) AddToCluster(newit);
 
     nTransactionsUpdated++;
     totalTxSize += entry.GetTxSize();
@@ -494,6 +610,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
 
     vTxHashes.emplace_back(tx.GetWitnessHash(), newit);
     newit->vTxHashesIdx = vTxHashes.size() - 1;
+    m_snapshot.Add(GetInfo(newit));
 }
 
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
@@ -525,6 +642,9 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     } else
         vTxHashes.clear();
 
+    if (m_track_clusters) RemoveFromCluster(it);
+    m_snapshot.Remove(it->GetTx());
+
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
     cachedInnerUsage -= it->DynamicMemoryUsage();
@@ -618,6 +738,7 @@ void CTxMemPool::removeConflicts(const CTransaction &tx)
 {
     // Remove transactions which depend on inputs of tx, recursively
     AssertLockHeld(cs);
+    const SnapshotBatch snapshot_batch{*this};
     for (const CTxIn &txin : tx.vin) {
         auto it = mapNextTx.find(txin.prevout);
         if (it != mapNextTx.end()) {
@@ -637,6 +758,7 @@ void CTxMemPool::removeConflicts(const CTransaction &tx)
 void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight)
 {
     AssertLockHeld(cs);
+    const SnapshotBatch snapshot_batch{*this};
     std::vector<const CTxMemPoolEntry*> entries;
     for (const auto& tx : vtx)
     {
@@ -666,7 +788,9 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
 void CTxMemPool::_clear()
 {
     vTxHashes.clear();
+    m_clusters.clear();
     mapTx.clear();
+    m_snapshot.Clear();
     mapNextTx.clear();
     totalTxSize = 0;
     m_total_fee = 0;
@@ -697,6 +821,7 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     CAmount check_total_fee{0};
     uint64_t innerUsage = 0;
     uint64_t prev_ancestor_count{0};
+    size_t clustered_txs{0};
 
     CCoinsViewCache mempoolDuplicate(const_cast<CCoinsViewCache*>(&active_coins_tip));
 
@@ -770,6 +895,16 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         // just a sanity check, not definitive that this calc is correct...
         assert(it->GetSizeWithDescendants() >= child_sizes + it->GetTxSize());
 
+        if (m_track_clusters) {
+            // Check that the tx is where its cluster says, and that it shares it with its parents and children.
+            assert(it->m_cluster != nullptr);
+            assert(it->m_cluster->txs.at(it->m_cluster_pos) == &*it);
+            assert(m_clusters.at(it->m_cluster->index).get() == it->m_cluster);
+            for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) assert(parent.m_cluster == it->m_cluster);
+            for (const CTxMemPoolEntry& child : it->GetMemPoolChildrenConst()) assert(child.m_cluster == it->m_cluster);
+            clustered_txs += 1;
+        }
+
         TxValidationState dummy_state; // Not used. CheckTxInputs() should always pass
         CAmount txfee = 0;
         assert(!tx.IsCoinBase());
@@ -788,6 +923,20 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
     assert(innerUsage == cachedInnerUsage);
+    // The published snapshot matches mapTx
+    assert(m_snapshot.GetAll().size() == mapTx.size());
+    for (const CTxMemPoolEntry& entry : mapTx) {
+        assert(m_snapshot.Contains(GenTxid::Txid(entry.GetTx().GetHash())));
+        assert(m_snapshot.Get(GenTxid::Wtxid(entry.GetTx().GetWitnessHash()))->nFeeDelta == entry.GetModifiedFee() - entry.GetFee());
+    }
+    if (m_track_clusters) {
+        size_t cluster_txs{0};
+        for (const auto& cluster : m_clusters) {
+            assert(!cluster->txs.empty());
+            cluster_txs += cluster->txs.size();
+        }
+        assert(cluster_txs == clustered_txs);
+    }
 }
 
 bool CTxMemPool::CompareDepthAndScore(const uint256& hasha, const uint256& hashb, bool wtxid)
@@ -848,10 +997,6 @@ void CTxMemPool::queryHashes(std::vector<uint256>& vtxid) const
     }
 }
 
-static TxMempoolInfo GetInfo(CTxMemPool::indexed_transaction_set::const_iterator it) {
-    return TxMempoolInfo{it->GetSharedTx(), it->GetTime(), it->GetFee(), it->GetTxSize(), it->GetModifiedFee() - it->GetFee()};
-}
-
 std::vector<TxMempoolInfo> CTxMemPool::infoAll() const
 {
     LOCK(cs);
@@ -868,20 +1013,13 @@ std::vector<TxMempoolInfo> CTxMemPool::infoAll() const
 
 CTransactionRef CTxMemPool::get(const uint256& hash) const
 {
-    LOCK(cs);
-    indexed_transaction_set::const_iterator i = mapTx.find(hash);
-    if (i == mapTx.end())
-        return nullptr;
-    return i->GetSharedTx();
+    const std::optional<TxMempoolInfo> info{m_snapshot.Get(GenTxid::Txid(hash))};
+    return info ? info->tx : nullptr;
 }
 
 TxMempoolInfo CTxMemPool::info(const GenTxid& gtxid) const
 {
-    LOCK(cs);
-    indexed_transaction_set::const_iterator i = (gtxid.IsWtxid() ? get_iter_from_wtxid(gtxid.GetHash()) : mapTx.find(gtxid.GetHash()));
-    if (i == mapTx.end())
-        return TxMempoolInfo();
-    return GetInfo(i);
+    return m_snapshot.Get(gtxid).value_or(TxMempoolInfo{});
 }
 
 void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeDelta)
@@ -893,6 +1031,9 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
         txiter it = mapTx.find(hash);
         if (it != mapTx.end()) {
             mapTx.modify(it, [&nFeeDelta](CTxMemPoolEntry& e) { e.UpdateModifiedFee(nFeeDelta); });
+            if (m_track_clusters) it->m_cluster->linearized = false;
+            const SnapshotBatch snapshot_batch{*this};
+            m_snapshot.SetFeeDelta(it->GetTx(), it->GetModifiedFee() - it->GetFee());
             // Now update all ancestors' modified fees with descendants
             setEntries setAncestors;
             std::string dummy;
@@ -955,7 +1096,7 @@ CTxMemPool::setEntries CTxMemPool::GetIterSet(const std::set<uint256>& hashes) c
 bool CTxMemPool::HasNoInputsOf(const CTransaction &tx) const
 {
     for (unsigned int i = 0; i < tx.vin.size(); i++)
-        if (exists(GenTxid::Txid(tx.vin[i].prevout.hash)))
+        if (mapTx.count(tx.vin[i].prevout.hash))
             return false;
     return true;
 }
@@ -966,6 +1107,7 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     // Check to see if the inputs are made available by another tx in the package.
     // These Coins would not be available in the underlying CoinsView.
     if (auto it = m_temp_added.find(outpoint); it != m_temp_added.end()) {
+        m_non_base_coins.emplace(outpoint);
         coin = it->second;
         return true;
     }
@@ -977,6 +1119,7 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     if (ptx) {
         if (outpoint.n < ptx->vout.size()) {
             coin = Coin(ptx->vout[outpoint.n], MEMPOOL_HEIGHT, false);
+            m_non_base_coins.emplace(outpoint);
             return true;
         } else {
             return false;
@@ -992,10 +1135,22 @@ void CCoinsViewMemPool::PackageAddTransaction(const CTransactionRef& tx)
     }
 }
 
+void CCoinsViewMemPool::Reset()
+{
+    m_temp_added.clear();
+    m_non_base_coins.clear();
+}
+
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    size_t usage{memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + m_snapshot.DynamicMemoryUsage() + cachedInnerUsage};
+    if (m_track_clusters) {
+        // Estimate each cluster to need one tx pointer and one chunk per transaction.
+        usage += memusage::DynamicUsage(m_clusters) + memusage::MallocUsage(sizeof(TxMempoolCluster)) * m_clusters.size() +
+                 (sizeof(const CTxMemPoolEntry*) + sizeof(TxMempoolCluster::Chunk)) * mapTx.size();
+    }
+    return usage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1009,6 +1164,7 @@ void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked)
 
 void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
     AssertLockHeld(cs);
+    const SnapshotBatch snapshot_batch{*this};
     UpdateForRemoveFromMempool(stage, updateDescendants);
     for (txiter it : stage) {
         removeUnchecked(it, reason);
@@ -1094,25 +1250,327 @@ void CTxMemPool::trackPackageRemoved(const CFeeRate& rate) {
     }
 }
 
+namespace {
+/** Clusters larger than this are linearized by ancestor count instead of by ancestor set feerate. */
+constexpr size_t MAX_CLUSTER_LINEARIZE_BY_FEERATE{500};
+
+bool HigherFeeRate(CAmount fee_a, int64_t size_a, CAmount fee_b, int64_t size_b)
+{
+    return double(fee_a) * size_b > double(fee_b) * size_a;
+}
+
+/**
+ * Order the transactions of a cluster by repeatedly picking the remaining
+ * transaction with the highest feerate including its remaining ancestors,
+ * together with those ancestors, and split the result into chunks.
+ */
+void LinearizeCluster(TxMempoolCluster& cluster)
+{
+    const size_t count{cluster.txs.size()};
+    std::vector<const CTxMemPoolEntry*> order;
+    order.reserve(count);
+    const auto by_ancestor_count{[](const CTxMemPoolEntry* a, const CTxMemPoolEntry* b) {
+        return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+    }};
+
+    if (count > MAX_CLUSTER_LINEARIZE_BY_FEERATE) {
+        // Any order in which parents come before their children is valid.
+        order = cluster.txs;
+        std::stable_sort(order.begin(), order.end(), by_ancestor_count);
+    } else {
+        // All in-mempool ancestors of a transaction are in its cluster, so the
+        // ancestor state of the entries is where the ancestor set feerates start.
+        std::vector<CAmount> anc_fee(count);
+        std::vector<int64_t> anc_size(count);
+        for (size_t i = 0; i < count; ++i) {
+            anc_fee[i] = cluster.txs[i]->GetModFeesWithAncestors();
+            anc_size[i] = cluster.txs[i]->GetSizeWithAncestors();
+        }
+        std::vector<bool> done(count, false);
+        // Per transaction, the last walk that reached it
+        std::vector<size_t> seen(count, 0);
+        size_t walk{0};
+        std::vector<size_t> todo, picked;
+        while (order.size() < count) {
+            size_t best{count};
+            for (size_t i = 0; i < count; ++i) {
+                if (done[i]) continue;
+                if (best == count || HigherFeeRate(anc_fee[i], anc_size[i], anc_fee[best], anc_size[best])) best = i;
+            }
+            // Collect the remaining ancestors of best.
+            picked.clear();
+            todo.assign(1, best);
+            seen[best] = ++walk;
+            while (!todo.empty()) {
+                const size_t i{todo.back()};
+                todo.pop_back();
+                picked.push_back(i);
+                for (const CTxMemPoolEntry& parent : cluster.txs[i]->GetMemPoolParentsConst()) {
+                    const size_t p{parent.m_cluster_pos};
+                    if (!done[p] && seen[p] != walk) {
+                        seen[p] = walk;
+                        todo.push_back(p);
+                    }
+                }
+            }
+            std::sort(picked.begin(), picked.end(), [&](size_t a, size_t b) { return by_ancestor_count(cluster.txs[a], cluster.txs[b]); });
+            for (const size_t i : picked) {
+                done[i] = true;
+                order.push_back(cluster.txs[i]);
+            }
+            // Take them out of the ancestor sets of their remaining descendants.
+            for (const size_t i : picked) {
+                const CTxMemPoolEntry& entry{*cluster.txs[i]};
+                todo.assign(1, i);
+                ++walk;
+                while (!todo.empty()) {
+                    const size_t j{todo.back()};
+                    todo.pop_back();
+                    for (const CTxMemPoolEntry& child : cluster.txs[j]->GetMemPoolChildrenConst()) {
+                        const size_t c{child.m_cluster_pos};
+                        if (done[c] || seen[c] == walk) continue;
+                        seen[c] = walk;
+                        anc_fee[c] -= entry.GetModifiedFee();
+                        anc_size[c] -= entry.GetTxSize();
+                        todo.push_back(c);
+                    }
+                }
+            }
+        }
+    }
+
+    // Merge each transaction into the preceding chunks while it has a higher
+    // feerate than them, so that chunk feerates are non-increasing.
+    cluster.chunks.clear();
+    for (size_t i = 0; i < count; ++i) {
+        order[i]->m_cluster_pos = i;
+        cluster.chunks.push_back({1, order[i]->GetModifiedFee(), int64_t(order[i]->GetTxSize())});
+        while (cluster.chunks.size() > 1) {
+            TxMempoolCluster::Chunk& last{cluster.chunks.back()};
+            TxMempoolCluster::Chunk& prev{cluster.chunks[cluster.chunks.size() - 2]};
+            if (!HigherFeeRate(last.fee, last.size, prev.fee, prev.size)) break;
+            prev.count += last.count;
+            prev.fee += last.fee;
+            prev.size += last.size;
+            cluster.chunks.pop_back();
+        }
+    }
+    cluster.txs = std::move(order);
+    cluster.linearized = true;
+}
+} // namespace
+
+TxMempoolCluster& CTxMemPool::NewCluster() const
+{
+    AssertLockHeld(cs);
+    m_clusters.push_back(std::make_unique<TxMempoolCluster>());
+    m_clusters.back()->index = m_clusters.size() - 1;
+    return *m_clusters.back();
+}
+
+void CTxMemPool::DeleteCluster(TxMempoolCluster& cluster) const
+{
+    AssertLockHeld(cs);
+    const size_t index{cluster.index};
+    if (index + 1 != m_clusters.size()) {
+        m_clusters[index] = std::move(m_clusters.back());
+        m_clusters[index]->index = index;
+    }
+    m_clusters.pop_back();
+}
+
+TxMempoolCluster& CTxMemPool::MergeClusters(TxMempoolCluster& a, TxMempoolCluster& b)
+{
+    AssertLockHeld(cs);
+    TxMempoolCluster& to{a.txs.size() >= b.txs.size() ? a : b};
+    TxMempoolCluster& from{&to == &a ? b : a};
+    for (const CTxMemPoolEntry* entry : from.txs) {
+        entry->m_cluster = &to;
+        entry->m_cluster_pos = to.txs.size();
+        to.txs.push_back(entry);
+    }
+    to.linearized = false;
+    to.maybe_split |= from.maybe_split;
+    DeleteCluster(from);
+    return to;
+}
+
+void CTxMemPool::AddToCluster(txiter it)
+{
+    AssertLockHeld(cs);
+    TxMempoolCluster* cluster{nullptr};
+    for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+        if (cluster == nullptr) {
+            cluster = parent.m_cluster;
+        } else if (parent.m_cluster != cluster) {
+            cluster = &MergeClusters(*cluster, *parent.m_cluster);
+        }
+    }
+    if (cluster == nullptr) cluster = &NewCluster();
+    it->m_cluster = cluster;
+    it->m_cluster_pos = cluster->txs.size();
+    cluster->txs.push_back(&*it);
+    cluster->linearized = false;
+}
+
+void CTxMemPool::RemoveFromCluster(txiter it)
+{
+    AssertLockHeld(cs);
+    TxMempoolCluster& cluster{*it->m_cluster};
+    const size_t pos{it->m_cluster_pos};
+    cluster.txs[pos] = cluster.txs.back();
+    cluster.txs[pos]->m_cluster_pos = pos;
+    cluster.txs.pop_back();
+    if (cluster.txs.empty()) {
+        DeleteCluster(cluster);
+        return;
+    }
+    cluster.linearized = false;
+    cluster.maybe_split = true;
+}
+
+void CTxMemPool::UpdateCluster(TxMempoolCluster& cluster) const
+{
+    AssertLockHeld(cs);
+    if (!cluster.maybe_split) {
+        LinearizeCluster(cluster);
+        return;
+    }
+    // The first connected component stays in cluster, every other one gets a new cluster.
+    const std::vector<const CTxMemPoolEntry*> txs{std::move(cluster.txs)};
+    cluster.txs.clear();
+    cluster.maybe_split = false;
+    std::vector<TxMempoolCluster*> components;
+    std::vector<const CTxMemPoolEntry*> todo;
+    WITH_FRESH_EPOCH(m_epoch);
+    for (const CTxMemPoolEntry* start : txs) {
+        if (m_epoch.visited(start->m_epoch_marker)) continue;
+        TxMempoolCluster& component{components.empty() ? cluster : NewCluster()};
+        components.push_back(&component);
+        todo.assign(1, start);
+        while (!todo.empty()) {
+            const CTxMemPoolEntry* entry{todo.back()};
+            todo.pop_back();
+            entry->m_cluster = &component;
+            entry->m_cluster_pos = component.txs.size();
+            component.txs.push_back(entry);
+            for (const CTxMemPoolEntry& parent : entry->GetMemPoolParentsConst()) {
+                if (!m_epoch.visited(parent.m_epoch_marker)) todo.push_back(&parent);
+            }
+            for (const CTxMemPoolEntry& child : entry->GetMemPoolChildrenConst()) {
+                if (!m_epoch.visited(child.m_epoch_marker)) todo.push_back(&child);
+            }
+        }
+    }
+    for (TxMempoolCluster* component : components) {
+        LinearizeCluster(*component);
+    }
+}
+
+std::vector<const TxMempoolCluster*> CTxMemPool::GetClusters() const
+{
+    AssertLockHeld(cs);
+    Assume(m_track_clusters);
+    // Splitting appends new clusters, which are linearized already.
+    for (size_t i = 0; i < m_clusters.size(); ++i) {
+        if (!m_clusters[i]->linearized) UpdateCluster(*m_clusters[i]);
+    }
+    std::vector<const TxMempoolCluster*> clusters;
+    clusters.reserve(m_clusters.size());
+    for (const auto& cluster : m_clusters) {
+        clusters.push_back(cluster.get());
+    }
+    return clusters;
+}
+
+const TxMempoolCluster& CTxMemPool::GetCluster(txiter it) const
+{
+    AssertLockHeld(cs);
+    Assume(m_track_clusters);
+    if (!it->m_cluster->linearized) UpdateCluster(*it->m_cluster);
+    return *it->m_cluster;
+}
+
+CFeeRate CTxMemPool::GetChunkFeeRate(txiter it) const
+{
+    AssertLockHeld(cs);
+    const TxMempoolCluster& cluster{GetCluster(it)};
+    auto chunk{cluster.chunks.begin()};
+    size_t end{chunk->count};
+    while (it->m_cluster_pos >= end) {
+        end += (++chunk)->count;
+    }
+    return CFeeRate(chunk->fee, chunk->size);
+}
+
 void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpendsRemaining) {
     AssertLockHeld(cs);
+    const SnapshotBatch snapshot_batch{*this};
 
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
+
+    // When tracking clusters, evict the chunk that would be mined last: the
+    // lowest feerate one among the last chunks of all clusters. Those are
+    // queued by the txid of their last transaction, and entries of clusters
+    // that changed since are skipped.
+    struct LastChunk {
+        CAmount fee;
+        int64_t size;
+        uint256 txid;
+    };
+    const auto higher_feerate{[](const LastChunk& a, const LastChunk& b) { return HigherFeeRate(a.fee, a.size, b.fee, b.size); }};
+    std::priority_queue<LastChunk, std::vector<LastChunk>, decltype(higher_feerate)> last_chunks{higher_feerate};
+    const auto push_last_chunk{[&](const TxMempoolCluster& cluster) {
+        last_chunks.push({cluster.chunks.back().fee, cluster.chunks.back().size, cluster.txs.back()->GetTx().GetHash()});
+    }};
+    if (m_track_clusters && !mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
+        for (const TxMempoolCluster* cluster : GetClusters()) {
+            push_last_chunk(*cluster);
+        }
+    }
+
     while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+        setEntries stage;
+        CFeeRate removed;
+        std::set<uint256> parents;
+        if (m_track_clusters) {
+            const TxMempoolCluster* cluster{nullptr};
+            while (cluster == nullptr && !last_chunks.empty()) {
+                const LastChunk last{last_chunks.top()};
+                last_chunks.pop();
+                const auto it{mapTx.find(last.txid)};
+                if (it == mapTx.end()) continue;
+                const TxMempoolCluster& candidate{GetCluster(it)};
+                if (candidate.txs.back() != &*it || candidate.chunks.back().fee != last.fee || candidate.chunks.back().size != last.size) continue;
+                cluster = &candidate;
+            }
+            if (cluster == nullptr) break;
+            const TxMempoolCluster::Chunk& chunk{cluster->chunks.back()};
+            removed = CFeeRate(chunk.fee, chunk.size);
+            // Nothing in the cluster depends on its last chunk.
+            for (auto entry{cluster->txs.end() - chunk.count}; entry != cluster->txs.end(); ++entry) {
+                stage.insert(mapTx.iterator_to(**entry));
+            }
+            for (txiter it : stage) {
+                for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+                    if (parent.m_cluster_pos < cluster->txs.size() - chunk.count) parents.insert(parent.GetTx().GetHash());
+                }
+            }
+        } else {
+            indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+            removed = CFeeRate(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+            CalculateDescendants(mapTx.project<0>(it), stage);
+        }
 
         // We set the new mempool min fee to the feerate of the removed set, plus the
         // "minimum reasonable fee rate" (ie some value under which we consider txn
         // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
         // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
         removed += m_incremental_relay_feerate;
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1125,11 +1583,15 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
         if (pvNoSpendsRemaining) {
             for (const CTransaction& tx : txn) {
                 for (const CTxIn& txin : tx.vin) {
-                    if (exists(GenTxid::Txid(txin.prevout.hash))) continue;
+                    if (mapTx.count(txin.prevout.hash)) continue;
                     pvNoSpendsRemaining->push_back(txin.prevout);
                 }
             }
         }
+        // The remaining transactions of the cluster have a new last chunk.
+        for (const uint256& txid : parents) {
+            push_last_chunk(GetCluster(mapTx.find(txid)));
+        }
     }
 
     if (maxFeeRateRemoved > CFeeRate(0)) {
@@ -6,11 +6,14 @@
 #ifndef BITCOIN_TXMEMPOOL_H
 #define BITCOIN_TXMEMPOOL_H
 
+#include <array>
 #include <atomic>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -73,6 +76,39 @@ struct CompareIteratorByHash {
     }
 };
 
+class CTxMemPoolEntry;
+
+/**
+ * A set of mempool transactions that are connected through spends, together
+ * with a linearization of it: an order in which the transactions can be
+ * included in a block, split into chunks of non-increasing feerate. Chunks
+ * are mined and evicted as a whole, so the feerate of the chunk a
+ * transaction belongs to is its mining score.
+ *
+ * Only maintained by a mempool that tracks clusters. The linearization is
+ * recomputed lazily, see CTxMemPool::GetCluster().
+ */
+struct TxMempoolCluster {
+    struct Chunk {
+        //! Number of transactions in the chunk
+        size_t count;
+        //! Modified fees and virtual size of the chunk
+        CAmount fee;
+        int64_t size;
+    };
+
+    //! The transactions, in linearization order if `linearized`
+    std::vector<const CTxMemPoolEntry*> txs;
+    //! Consecutive ranges of txs, if `linearized`
+    std::vector<Chunk> chunks;
+    //! Whether txs is in linearization order and chunks is up to date
+    bool linearized{false};
+    //! Whether transactions were removed, so the rest may no longer be connected
+    bool maybe_split{false};
+    //! Index in CTxMemPool::m_clusters
+    size_t index;
+};
+
 /** \class CTxMemPoolEntry
  *
  * CTxMemPoolEntry stores data about the corresponding transaction, as well
@@ -164,6 +200,8 @@ public:
     Children& GetMemPoolChildren() const { return m_children; }
 
     mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes
+    mutable TxMempoolCluster* m_cluster{nullptr}; //!< Cluster containing this tx, if the mempool tracks clusters
+    mutable size_t m_cluster_pos{0}; //!< Index in m_cluster->txs
     mutable Epoch::Marker m_epoch_marker; //!< epoch when last touched, useful for graph algorithms
 };
 
@@ -343,6 +381,65 @@ struct TxMempoolInfo
     int64_t nFeeDelta;
 };
 
+/**
+ * Copy of the transaction info of a mempool, indexed by txid and by wtxid,
+ * that can be queried without taking CTxMemPool::cs.
+ *
+ * Both indexes are split into shards by a salted hash. The mempool stages its
+ * changes in private copies of the shards it touches and publishes them when
+ * a batch of changes is complete, so a shard is copied at most once per batch.
+ * Readers only briefly lock a shard to take a reference to its published
+ * version. They always see each shard in a consistent state, but may see a
+ * batch published to one shard and not yet to another.
+ */
+class TxMempoolSnapshot
+{
+public:
+    //! A change outside of a batch copies a whole shard, so keep them at a few
+    //! hundred entries even for a mempool of several 100k transactions
+    static constexpr size_t SHARD_COUNT{1024};
+
+    TxMempoolSnapshot();
+
+    /** Return the info of the given transaction, if it is in the published snapshot. */
+    std::optional<TxMempoolInfo> Get(const GenTxid& gtxid) const;
+    bool Contains(const GenTxid& gtxid) const { return Get(gtxid).has_value(); }
+    /** Return the info of all transactions, in no particular order. */
+    std::vector<TxMempoolInfo> GetAll() const;
+
+    // Staging changes, which is serialized by CTxMemPool::cs
+    void Add(const TxMempoolInfo& info);
+    void Remove(const CTransaction& tx);
+    void SetFeeDelta(const CTransaction& tx, int64_t fee_delta);
+    /** Make the staged changes visible to readers. */
+    void Publish();
+    /** Remove all transactions, and publish that right away. */
+    void Clear();
+    size_t DynamicMemoryUsage() const;
+
+private:
+    using Entries = std::vector<std::pair<uint256, TxMempoolInfo>>; //!< Sorted by hash
+
+    struct Shard {
+        mutable Mutex m_mutex;
+        std::shared_ptr<const Entries> m_published GUARDED_BY(m_mutex);
+        //! Copy of m_published with the staged changes, if there are any
+        std::shared_ptr<Entries> m_staged;
+    };
+
+    const SaltedTxidHasher m_hasher;
+    std::array<Shard, SHARD_COUNT> m_by_txid;
+    std::array<Shard, SHARD_COUNT> m_by_wtxid;
+    std::vector<Shard*> m_dirty;
+    //! Number of transactions, including staged changes
+    size_t m_size{0};
+
+    Shard& GetShard(std::array<Shard, SHARD_COUNT>& shards, const uint256& hash) { return shards[m_hasher(hash) % SHARD_COUNT]; }
+    const Shard& GetShard(const std::array<Shard, SHARD_COUNT>& shards, const uint256& hash) const { return shards[m_hasher(hash) % SHARD_COUNT]; }
+    /** Return the staged entries of the shard, copying the published ones first if needed. */
+    Entries& Stage(Shard& shard);
+};
+
 /** Reason why a transaction was removed from the mempool,
  * this is passed to the notification signal.
  */
@@ -453,6 +550,29 @@ protected:
 
     bool m_load_tried GUARDED_BY(cs){false};
 
+    /** Lock-free copy of the transaction info, see TxMempoolSnapshot. Changed only with cs held. */
+    TxMempoolSnapshot m_snapshot;
+    //! Nesting depth of SnapshotBatch instances, only accessed with cs held
+    int m_snapshot_batches{0};
+
+    /** Publishes the changes staged in m_snapshot when the outermost batch ends. */
+    class SnapshotBatch
+    {
+        CTxMemPool& m_pool;
+
+    public:
+        explicit SnapshotBatch(CTxMemPool& pool) EXCLUSIVE_LOCKS_REQUIRED(pool.cs) : m_pool{pool} { ++m_pool.m_snapshot_batches; }
+        ~SnapshotBatch()
+        {
+            if (--m_pool.m_snapshot_batches == 0) m_pool.m_snapshot.Publish();
+        }
+        SnapshotBatch(const SnapshotBatch&) = delete;
+        SnapshotBatch& operator=(const SnapshotBatch&) = delete;
+    };
+
+    /** All clusters, in no particular order, if m_track_clusters. */
+    mutable std::vector<std::unique_ptr<TxMempoolCluster>> m_clusters GUARDED_BY(cs);
+
     CFeeRate GetMinFee(size_t sizelimit) const;
 
 public:
@@ -580,6 +700,7 @@ public:
     const std::optional<unsigned> m_max_datacarrier_bytes;
     const bool m_require_standard;
     const bool m_full_rbf;
+    const bool m_track_clusters;
 
     const Limits m_limits;
 
@@ -729,6 +850,19 @@ public:
       */
     void TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpendsRemaining = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /**
+     * Return all clusters, each with an up to date linearization. Requires
+     * m_track_clusters. The pointers are invalidated by any change to the
+     * mempool.
+     */
+    std::vector<const TxMempoolCluster*> GetClusters() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /** Return the cluster containing it, with an up to date linearization. Requires m_track_clusters. */
+    const TxMempoolCluster& GetCluster(txiter it) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /** Return the feerate of the chunk containing it. Requires m_track_clusters. */
+    CFeeRate GetChunkFeeRate(txiter it) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Expire all transaction (and their dependencies) in the mempool older than time. Return the number of removed transactions. */
     int Expire(std::chrono::seconds time) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -770,22 +904,25 @@ public:
         return m_total_fee;
     }
 
+    /** Whether the transaction is in the mempool. Does not take cs, see TxMempoolSnapshot. */
     bool exists(const GenTxid& gtxid) const
     {
-        LOCK(cs);
-        if (gtxid.IsWtxid()) {
-            return (mapTx.get<index_by_wtxid>().count(gtxid.GetHash()) != 0);
-        }
-        return (mapTx.count(gtxid.GetHash()) != 0);
+        return m_snapshot.Contains(gtxid);
     }
 
+    /** Lock-free view of the transactions in the mempool. */
+    const TxMempoolSnapshot& GetSnapshot() const { return m_snapshot; }
+
+    /** Return the transaction, if it is in the mempool. Does not take cs, see TxMempoolSnapshot. */
     CTransactionRef get(const uint256& hash) const;
     txiter get_iter_from_wtxid(const uint256& wtxid) const EXCLUSIVE_LOCKS_REQUIRED(cs)
     {
         AssertLockHeld(cs);
         return mapTx.project<0>(mapTx.get<index_by_wtxid>().find(wtxid));
     }
+    /** Return the info of the transaction, if it is in the mempool. Does not take cs, see TxMempoolSnapshot. */
     TxMempoolInfo info(const GenTxid& gtxid) const;
+    /** Return the info of all transactions, parents before children. */
     std::vector<TxMempoolInfo> infoAll() const;
 
     size_t DynamicMemoryUsage() const;
@@ -876,6 +1013,16 @@ private:
      *  removal.
      */
     void removeUnchecked(txiter entry, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    TxMempoolCluster& NewCluster() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void DeleteCluster(TxMempoolCluster& cluster) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Move the transactions of the smaller cluster into the larger one, and return the latter. */
+    TxMempoolCluster& MergeClusters(TxMempoolCluster& a, TxMempoolCluster& b) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Add a new entry to the cluster of its in-mempool parents, merging them if needed. */
+    void AddToCluster(txiter it) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void RemoveFromCluster(txiter it) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Split cluster into its connected components if needed, and linearize each of them. */
+    void UpdateCluster(TxMempoolCluster& cluster) const EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 public:
     /** visited marks a CTxMemPoolEntry as having been traversed
      * during the lifetime of the most recently created Epoch::Guard
@@ -917,6 +1064,13 @@ class CCoinsViewMemPool : public CCoinsViewBacked
     * validation, since we can access transaction outputs without submitting them to mempool.
     */
     std::unordered_map<COutPoint, Coin, SaltedOutpointHasher> m_temp_added;
+
+    /**
+    * Set of coins that were fetched from the mempool or m_temp_added rather than the backend.
+    * These may go stale once the mempool changes, so caches layered on top of this view need to
+    * drop them before they are reused.
+    */
+    mutable std::unordered_set<COutPoint, SaltedOutpointHasher> m_non_base_coins;
 protected:
     const CTxMemPool& mempool;
 
@@ -926,6 +1080,10 @@ public:
     /** Add the coins created by this transaction. These coins are only temporarily stored in
      * m_temp_added and cannot be flushed to the back end. Only used for package validation. */
     void PackageAddTransaction(const CTransactionRef& tx);
+    /** Get all coins in m_non_base_coins. */
+    const std::unordered_set<COutPoint, SaltedOutpointHasher>& GetNonBaseCoins() const { return m_non_base_coins; }
+    /** Clear m_temp_added and m_non_base_coins. */
+    void Reset();
 };
 
 /**
@@ -0,0 +1,66 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <util/mappedfile.h>
+
+#include <cstdio>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef WIN32
+
+MappedFile::MappedFile(const fs::path& path)
+{
+    const int fd{open(path.c_str(), O_RDONLY)};
+    if (fd == -1) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* addr{mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+        if (addr != MAP_FAILED) {
+            // Readers walk the file front to back
+            posix_madvise(addr, st.st_size, POSIX_MADV_SEQUENTIAL);
+            m_data = static_cast<const std::byte*>(addr);
+            m_size = st.st_size;
+        }
+    }
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data) munmap(const_cast<std::byte*>(m_data), m_size);
+}
+
+#else
+
+MappedFile::MappedFile(const fs::path& path)
+{
+    FILE* file{fsbridge::fopen(path, "rb")};
+    if (!file) return;
+    std::byte buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        m_buffer.insert(m_buffer.end(), buffer, buffer + n);
+    }
+    const bool ok{!ferror(file)};
+    fclose(file);
+    if (ok && !m_buffer.empty()) {
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+}
+
+MappedFile::~MappedFile() = default;
+
+#endif
@@ -0,0 +1,43 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_MAPPEDFILE_H
+#define BITCOIN_UTIL_MAPPEDFILE_H
+
+#include <fs.h>
+#include <span.h>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Read-only view of the full contents of a file.
+ *
+ * The file is memory-mapped where the platform supports it, so that large
+ * files can be parsed in place without copying them into a buffer first. On
+ * other platforms the contents are read into memory once.
+ */
+class MappedFile
+{
+private:
+    const std::byte* m_data{nullptr};
+    size_t m_size{0};
+#ifdef WIN32
+    std::vector<std::byte> m_buffer;
+#endif
+
+public:
+    explicit MappedFile(const fs::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //! Whether the file could not be opened or mapped. Empty files are never mapped.
+    bool IsNull() const { return m_data == nullptr; }
+
+    Span<const std::byte> data() const { return {m_data, m_size}; }
+};
+
+#endif // BITCOIN_UTIL_MAPPEDFILE_H
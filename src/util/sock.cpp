@@ -24,6 +24,10 @@
 #include <poll.h>
 #endif
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 static inline bool IOErrorIsPermanent(int err)
 {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK && err != WSAEINPROGRESS;
@@ -416,6 +420,134 @@ void Sock::Close()
     m_socket = INVALID_SOCKET;
 }
 
+#ifdef USE_EPOLL
+static uint32_t EpollEvents(Sock::Event requested)
+{
+    uint32_t events{0};
+    if (requested & Sock::RECV) {
+        events |= EPOLLIN;
+    }
+    if (requested & Sock::SEND) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+SockWaitSet::SockWaitSet() : m_epoll_fd{epoll_create1(EPOLL_CLOEXEC)}
+{
+    if (m_epoll_fd == -1) {
+        LogPrintf("Failed to create epoll instance, falling back to poll: %s\n", SysErrorString(errno));
+    }
+}
+
+SockWaitSet::~SockWaitSet()
+{
+    if (m_epoll_fd != -1) {
+        close(m_epoll_fd);
+    }
+}
+
+bool SockWaitSet::Update(const Sock::EventsPerSock& events_per_sock)
+{
+    ++m_generation;
+    for (const auto& [sock, events] : events_per_sock) {
+        const SOCKET fd{sock->Get()};
+        epoll_event ev{};
+        ev.events = EpollEvents(events.requested);
+        ev.data.fd = fd;
+        auto [it, inserted] = m_registered.try_emplace(fd, Registration{sock, events.requested, m_generation});
+        if (inserted) {
+            if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+                m_registered.erase(it);
+                return false;
+            }
+            continue;
+        }
+        Registration& reg{it->second};
+        if (reg.sock.lock() != sock) {
+            // The socket registered under this number was closed, which removed it from the
+            // epoll instance, and a new one was created with the same number.
+            reg.sock = sock;
+            reg.requested = events.requested;
+            if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1 &&
+                (errno != EEXIST || epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev) == -1)) {
+                m_registered.erase(it);
+                return false;
+            }
+        } else if (reg.requested != events.requested) {
+            reg.requested = events.requested;
+            if (epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+                m_registered.erase(it);
+                return false;
+            }
+        }
+        reg.generation = m_generation;
+    }
+
+    if (m_registered.size() != events_per_sock.size()) {
+        for (auto it = m_registered.begin(); it != m_registered.end();) {
+            if (it->second.generation != m_generation) {
+                // This fails if the socket was closed already, which removed it from the epoll
+                // instance anyway.
+                epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, it->first, nullptr);
+                it = m_registered.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return true;
+}
+
+bool SockWaitSet::WaitMany(std::chrono::milliseconds timeout, Sock::EventsPerSock& events_per_sock)
+{
+    if (m_epoll_fd == -1 || !Update(events_per_sock)) {
+        return !events_per_sock.empty() && events_per_sock.begin()->first->WaitMany(timeout, events_per_sock);
+    }
+    if (events_per_sock.empty()) {
+        return false;
+    }
+
+    for (auto& [sock, events] : events_per_sock) {
+        events.occurred = 0;
+    }
+
+    std::vector<epoll_event> ready(events_per_sock.size());
+    const int num_ready{epoll_wait(m_epoll_fd, ready.data(), ready.size(), count_milliseconds(timeout))};
+    if (num_ready == -1) {
+        return false;
+    }
+
+    for (int i = 0; i < num_ready; ++i) {
+        const auto reg = m_registered.find(ready[i].data.fd);
+        if (reg == m_registered.end()) continue;
+        const auto it = events_per_sock.find(reg->second.sock.lock());
+        if (it == events_per_sock.end()) continue;
+        Sock::Events& events{it->second};
+        if (ready[i].events & EPOLLIN) {
+            events.occurred |= Sock::RECV;
+        }
+        if (ready[i].events & EPOLLOUT) {
+            events.occurred |= Sock::SEND;
+        }
+        if (ready[i].events & (EPOLLERR | EPOLLHUP)) {
+            events.occurred |= Sock::ERR;
+        }
+    }
+
+    return true;
+}
+#else
+SockWaitSet::SockWaitSet() = default;
+
+SockWaitSet::~SockWaitSet() = default;
+
+bool SockWaitSet::WaitMany(std::chrono::milliseconds timeout, Sock::EventsPerSock& events_per_sock)
+{
+    return !events_per_sock.empty() && events_per_sock.begin()->first->WaitMany(timeout, events_per_sock);
+}
+#endif // USE_EPOLL
+
 #ifdef WIN32
 std::string NetworkErrorString(int err)
 {
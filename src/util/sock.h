@@ -279,6 +279,49 @@ private:
     void Close();
 };
 
+/**
+ * A set of sockets to wait on, which stays registered with the kernel between calls to `WaitMany()`
+ * (using epoll(7), where available). Only sockets that were added or removed, or whose requested
+ * events changed since the previous call cause a syscall, so that the cost of a wait is in the
+ * number of ready sockets instead of all sockets. Elsewhere this falls back to `Sock::WaitMany()`.
+ * Not thread safe: each thread waiting on sockets should have its own instance.
+ */
+class SockWaitSet
+{
+public:
+    SockWaitSet();
+    ~SockWaitSet();
+
+    SockWaitSet(const SockWaitSet&) = delete;
+    SockWaitSet& operator=(const SockWaitSet&) = delete;
+
+    /**
+     * Same as `Sock::WaitMany()`, except that an empty `events_per_sock` is reported as a failure
+     * (after dropping all registered sockets), so that the caller can sleep instead.
+     * Sockets not in `events_per_sock` are removed from the set.
+     */
+    [[nodiscard]] bool WaitMany(std::chrono::milliseconds timeout, Sock::EventsPerSock& events_per_sock);
+
+private:
+#ifdef USE_EPOLL
+    struct Registration {
+        /** Not owning, so that a disconnected peer's socket is closed as soon as the caller drops it. */
+        std::weak_ptr<const Sock> sock;
+        Sock::Event requested;
+        /** Value of m_generation when the socket was last part of `events_per_sock`. */
+        uint64_t generation;
+    };
+
+    /** epoll instance, or -1 if it could not be created. */
+    int m_epoll_fd;
+    std::unordered_map<SOCKET, Registration> m_registered;
+    uint64_t m_generation{0};
+
+    /** Bring the kernel's interest list in line with `events_per_sock`. */
+    bool Update(const Sock::EventsPerSock& events_per_sock);
+#endif
+};
+
 /** Return readable error string for a network error code */
 std::string NetworkErrorString(int err);
 
@@ -895,8 +895,22 @@ void SetSyscallSandboxPolicy(SyscallSandboxPolicy syscall_policy)
     case SyscallSandboxPolicy::TX_INDEX: // Thread: txindex
         seccomp_policy_builder.AllowFileSystem();
         break;
+    case SyscallSandboxPolicy::VALIDATION_BLOCK_READ_AHEAD: // Thread: blockread.<N>
+        seccomp_policy_builder.AllowFileSystem();
+        break;
+    case SyscallSandboxPolicy::VALIDATION_COINS_FLUSH: // Thread: coinsflush
+        seccomp_policy_builder.AllowFileSystem();
+        break;
+    case SyscallSandboxPolicy::VALIDATION_PREFETCH: // Thread: prefetch.<N>
+        seccomp_policy_builder.AllowFileSystem();
+        break;
     case SyscallSandboxPolicy::VALIDATION_SCRIPT_CHECK: // Thread: scriptch.<N>
         break;
+    case SyscallSandboxPolicy::VALIDATION_SNAPSHOT: // Thread: snapshot.<N>
+        break;
+    case SyscallSandboxPolicy::VALIDATION_VERIFY_DB: // Thread: verifydb.<N>
+        seccomp_policy_builder.AllowFileSystem();
+        break;
     case SyscallSandboxPolicy::SHUTOFF: // Thread: main thread (state: shutoff)
         seccomp_policy_builder.AllowFileSystem();
         break;
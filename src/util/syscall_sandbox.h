@@ -22,7 +22,12 @@ enum class SyscallSandboxPolicy {
     SCHEDULER,
     TOR_CONTROL,
     TX_INDEX,
+    VALIDATION_BLOCK_READ_AHEAD,
+    VALIDATION_COINS_FLUSH,
+    VALIDATION_PREFETCH,
     VALIDATION_SCRIPT_CHECK,
+    VALIDATION_SNAPSHOT,
+    VALIDATION_VERIFY_DB,
 
     // 3. Shutdown
     SHUTOFF,
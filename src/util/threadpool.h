@@ -0,0 +1,136 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_THREADPOOL_H
+#define BITCOIN_UTIL_THREADPOOL_H
+
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/syscall_sandbox.h>
+#include <util/threadnames.h>
+
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * A fixed-size pool of worker threads executing submitted tasks in FIFO order.
+ *
+ * Like CCheckQueue, the worker threads are started and stopped explicitly by
+ * the owner of the pool. Tasks submitted while no workers are running are
+ * executed synchronously on the calling thread, so callers do not need a
+ * separate code path for the single-threaded case.
+ */
+class ThreadPool
+{
+private:
+    //! Prefix used to name the worker threads (<name>.<N>)
+    const std::string m_name;
+
+    Mutex m_mutex;
+    //! Worker threads block on this when out of work
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_work_queue GUARDED_BY(m_mutex);
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+    //! Number of running workers, readable by any thread submitting work
+    int m_num_workers GUARDED_BY(m_mutex){0};
+
+    std::vector<std::thread> m_worker_threads;
+
+    void WorkerThread() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_request_stop || !m_work_queue.empty(); });
+                // Drain the queue before exiting so that no submitted future is left unsatisfied.
+                if (m_work_queue.empty()) return;
+                task = std::move(m_work_queue.front());
+                m_work_queue.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit ThreadPool(std::string name) : m_name(std::move(name)) {}
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        assert(m_worker_threads.empty());
+    }
+
+    //! Create the worker threads, each restricted to the given syscall sandbox policy.
+    void Start(int threads_num, SyscallSandboxPolicy policy) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        assert(m_worker_threads.empty());
+        WITH_LOCK(m_mutex, m_num_workers = threads_num);
+        for (int n = 0; n < threads_num; ++n) {
+            m_worker_threads.emplace_back([this, n, policy]() {
+                util::ThreadRename(strprintf("%s.%i", m_name, n));
+                SetSyscallSandboxPolicy(policy);
+                WorkerThread();
+            });
+        }
+    }
+
+    //! Finish all queued tasks and stop the worker threads.
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WITH_LOCK(m_mutex, m_request_stop = true);
+        m_cv.notify_all();
+        for (std::thread& t : m_worker_threads) {
+            t.join();
+        }
+        m_worker_threads.clear();
+        LOCK(m_mutex);
+        m_request_stop = false;
+        m_num_workers = 0;
+    }
+
+    //! Number of running worker threads.
+    int WorkersCount() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        return WITH_LOCK(m_mutex, return m_num_workers);
+    }
+
+    /**
+     * Queue a task for execution by the workers.
+     *
+     * @returns a future holding the result of the task, or any exception it threw.
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F>> Submit(F&& fn) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        auto task{std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(fn))};
+        auto future{task->get_future()};
+        {
+            LOCK(m_mutex);
+            if (m_num_workers > 0) {
+                m_work_queue.emplace_back([task]() { (*task)(); });
+                task.reset();
+            }
+        }
+        if (task) {
+            (*task)();
+        } else {
+            m_cv.notify_one();
+        }
+        return future;
+    }
+};
+
+#endif // BITCOIN_UTIL_THREADPOOL_H
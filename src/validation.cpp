@@ -50,6 +50,7 @@
 #include <util/rbf.h>
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/threadpool.h>
 #include <util/time.h>
 #include <util/trace.h>
 #include <util/translation.h>
@@ -60,6 +61,7 @@
 #include <cassert>
 #include <chrono>
 #include <deque>
+#include <future>
 #include <numeric>
 #include <optional>
 #include <string>
@@ -458,11 +460,15 @@ public:
          * policies such as mempool min fee and min relay fee.
          */
         const bool m_package_feerates;
+        /** When true, the input scripts are not checked, because they were already checked
+         * against the same script verification flags before.
+         */
+        const bool m_skip_script_checks;
 
         /** Parameters for single transaction mempool validation. */
         static ATMPArgs SingleAccept(const CChainParams& chainparams, int64_t accept_time,
                                      bool bypass_limits, std::vector<COutPoint>& coins_to_uncache,
-                                     bool test_accept) {
+                                     bool test_accept, bool skip_script_checks) {
             return ATMPArgs{/* m_chainparams */ chainparams,
                             /* m_accept_time */ accept_time,
                             /* m_bypass_limits */ bypass_limits,
@@ -471,6 +477,7 @@ public:
                             /* m_allow_replacement */ true,
                             /* m_package_submission */ false,
                             /* m_package_feerates */ false,
+                            /* m_skip_script_checks */ skip_script_checks,
             };
         }
 
@@ -485,6 +492,7 @@ public:
                             /* m_allow_replacement */ false,
                             /* m_package_submission */ false, // not submitting to mempool
                             /* m_package_feerates */ false,
+                            /* m_skip_script_checks */ false,
             };
         }
 
@@ -499,6 +507,7 @@ public:
                             /* m_allow_replacement */ false,
                             /* m_package_submission */ true,
                             /* m_package_feerates */ true,
+                            /* m_skip_script_checks */ false,
             };
         }
 
@@ -512,6 +521,7 @@ public:
                             /* m_allow_replacement */ true,
                             /* m_package_submission */ false,
                             /* m_package_feerates */ false, // only 1 transaction
+                            /* m_skip_script_checks */ false,
             };
         }
 
@@ -525,7 +535,8 @@ public:
                  bool test_accept,
                  bool allow_replacement,
                  bool package_submission,
-                 bool package_feerates)
+                 bool package_feerates,
+                 bool skip_script_checks)
             : m_chainparams{chainparams},
               m_accept_time{accept_time},
               m_bypass_limits{bypass_limits},
@@ -533,7 +544,8 @@ public:
               m_test_accept{test_accept},
               m_allow_replacement{allow_replacement},
               m_package_submission{package_submission},
-              m_package_feerates{package_feerates}
+              m_package_feerates{package_feerates},
+              m_skip_script_checks{skip_script_checks}
         {
         }
     };
@@ -554,6 +566,13 @@ public:
      */
     PackageMempoolAcceptResult AcceptPackage(const Package& package, ATMPArgs& args) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Drop the coins m_view fetched from the mempool or from transactions being validated, as they
+     * may be spent or gone once the mempool changes. Confirmed coins stay cached, so later
+     * transactions validated with this MemPoolAccept don't fetch them from the chainstate again.
+     */
+    void CleanupTemporaryCoins();
+
 private:
     // All the intermediate state that gets passed between the various levels
     // of checking a given transaction.
@@ -939,7 +958,10 @@ bool MemPoolAccept::ReplacementChecks(Workspace& ws)
     //   guarantee that this is incentive-compatible for miners, because it is possible for a
     //   descendant transaction of a direct conflict to pay a higher feerate than the transaction that
     //   might replace them, under these rules.
-    if (const auto err_string{PaysMoreThanConflicts(ws.m_iters_conflicting, newFeeRate, hash)}) {
+    // - With cluster tracking, the feerates of the chunks of the direct conflicts are used instead,
+    //   which do include the descendants that would be mined along with them.
+    if (const auto err_string{m_pool.m_track_clusters ? PaysMoreThanConflictChunks(m_pool, ws.m_iters_conflicting, newFeeRate, hash) :
+                                                        PaysMoreThanConflicts(ws.m_iters_conflicting, newFeeRate, hash)}) {
         return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "insufficient fee", *err_string);
     }
 
@@ -1035,7 +1057,7 @@ bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws)
     // There is a similar check in CreateNewBlock() to prevent creating
     // invalid blocks (using TestBlockValidity), however allowing such
     // transactions into the mempool can be exploited as a DoS attack.
-    unsigned int currentBlockScriptVerifyFlags{GetBlockScriptFlags(*m_active_chainstate.m_chain.Tip(), m_active_chainstate.m_chainman)};
+    unsigned int currentBlockScriptVerifyFlags{GetMempoolScriptFlags(m_active_chainstate)};
     if (!CheckInputsFromMempoolAndCache(tx, state, m_view, m_pool, currentBlockScriptVerifyFlags,
                                         ws.m_precomputed_txdata, m_active_chainstate.CoinsTip())) {
         LogPrintf("BUG! PLEASE REPORT THIS! CheckInputScripts failed against latest-block but not STANDARD flags %s, %s\n", hash.ToString(), state.ToString());
@@ -1178,9 +1200,11 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
 
     // Perform the inexpensive checks first and avoid hashing and signature verification unless
     // those checks pass, to mitigate CPU exhaustion denial-of-service attacks.
-    if (!PolicyScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
+    if (!args.m_skip_script_checks) {
+        if (!PolicyScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
 
-    if (!ConsensusScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
+        if (!ConsensusScriptChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
+    }
 
     // Tx was accepted, but not added
     if (args.m_test_accept) {
@@ -1275,6 +1299,17 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
     return PackageMempoolAcceptResult(package_state, package_feerate, std::move(results));
 }
 
+void MemPoolAccept::CleanupTemporaryCoins()
+{
+    // The chain tip can't change while cs_main is held, so confirmed coins are still valid. A
+    // confirmed coin may since have been spent by a mempool transaction, which PreChecks detects
+    // as a mempool conflict.
+    for (const auto& outpoint : m_viewmempool.GetNonBaseCoins()) {
+        m_view.Uncache(outpoint);
+    }
+    m_viewmempool.Reset();
+}
+
 PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package& package, ATMPArgs& args)
 {
     AssertLockHeld(cs_main);
@@ -1369,6 +1404,7 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package& package,
             // Transaction does not already exist in the mempool.
             // Try submitting the transaction on its own.
             const auto single_res = AcceptSingleTransaction(tx, single_args);
+            CleanupTemporaryCoins();
             if (single_res.m_result_type == MempoolAcceptResult::ResultType::VALID) {
                 // The transaction succeeded on its own and is now in the mempool. Don't include it
                 // in package validation, because its fees should only be "used" once.
@@ -1386,6 +1422,7 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package& package,
                 // future.  Continue individually validating the rest of the transactions, because
                 // some of them may still be valid.
                 quit_early = true;
+                results.emplace(wtxid, single_res);
             } else {
                 txns_new.push_back(tx);
             }
@@ -1410,7 +1447,8 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package& package,
 } // anon namespace
 
 MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTransactionRef& tx,
-                                       int64_t accept_time, bool bypass_limits, bool test_accept)
+                                       int64_t accept_time, bool bypass_limits, bool test_accept,
+                                       bool skip_script_checks)
     EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
 {
     AssertLockHeld(::cs_main);
@@ -1419,7 +1457,7 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
     CTxMemPool& pool{*active_chainstate.GetMempool()};
 
     std::vector<COutPoint> coins_to_uncache;
-    auto args = MemPoolAccept::ATMPArgs::SingleAccept(chainparams, accept_time, bypass_limits, coins_to_uncache, test_accept);
+    auto args = MemPoolAccept::ATMPArgs::SingleAccept(chainparams, accept_time, bypass_limits, coins_to_uncache, test_accept, skip_script_checks);
     const MempoolAcceptResult result = MemPoolAccept(pool, active_chainstate).AcceptSingleTransaction(tx, args);
     if (result.m_result_type != MempoolAcceptResult::ResultType::VALID) {
         // Remove coins that were not present in the coins cache before calling
@@ -1436,36 +1474,56 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
     return result;
 }
 
+unsigned int GetMempoolScriptFlags(const Chainstate& active_chainstate)
+{
+    AssertLockHeld(cs_main);
+    return GetBlockScriptFlags(*Assert(active_chainstate.m_chain.Tip()), active_chainstate.m_chainman);
+}
+
 PackageMempoolAcceptResult ProcessNewPackage(Chainstate& active_chainstate, CTxMemPool& pool,
                                                    const Package& package, bool test_accept)
 {
     AssertLockHeld(cs_main);
-    assert(!package.empty());
-    assert(std::all_of(package.cbegin(), package.cend(), [](const auto& tx){return tx != nullptr;}));
+    return std::move(ProcessNewPackages(active_chainstate, pool, {package}, test_accept).front());
+}
 
-    std::vector<COutPoint> coins_to_uncache;
+std::vector<PackageMempoolAcceptResult> ProcessNewPackages(Chainstate& active_chainstate, CTxMemPool& pool,
+                                                           const std::vector<Package>& packages, bool test_accept)
+{
+    AssertLockHeld(cs_main);
     const CChainParams& chainparams = active_chainstate.m_params;
-    const auto result = [&]() EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
-        AssertLockHeld(cs_main);
-        if (test_accept) {
-            auto args = MemPoolAccept::ATMPArgs::PackageTestAccept(chainparams, GetTime(), coins_to_uncache);
-            return MemPoolAccept(pool, active_chainstate).AcceptMultipleTransactions(package, args);
-        } else {
-            auto args = MemPoolAccept::ATMPArgs::PackageChildWithParents(chainparams, GetTime(), coins_to_uncache);
-            return MemPoolAccept(pool, active_chainstate).AcceptPackage(package, args);
-        }
-    }();
+    // Confirmed coins fetched for one package stay cached in mempool_accept for the next ones.
+    MemPoolAccept mempool_accept(pool, active_chainstate);
+    std::vector<PackageMempoolAcceptResult> results;
+    results.reserve(packages.size());
+    for (const Package& package : packages) {
+        assert(!package.empty());
+        assert(std::all_of(package.cbegin(), package.cend(), [](const auto& tx){return tx != nullptr;}));
+
+        std::vector<COutPoint> coins_to_uncache;
+        const auto& result = results.emplace_back([&]() EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+            AssertLockHeld(cs_main);
+            if (test_accept) {
+                auto args = MemPoolAccept::ATMPArgs::PackageTestAccept(chainparams, GetTime(), coins_to_uncache);
+                return mempool_accept.AcceptMultipleTransactions(package, args);
+            } else {
+                auto args = MemPoolAccept::ATMPArgs::PackageChildWithParents(chainparams, GetTime(), coins_to_uncache);
+                return mempool_accept.AcceptPackage(package, args);
+            }
+        }());
+        mempool_accept.CleanupTemporaryCoins();
 
-    // Uncache coins pertaining to transactions that were not submitted to the mempool.
-    if (test_accept || result.m_state.IsInvalid()) {
-        for (const COutPoint& hashTx : coins_to_uncache) {
-            active_chainstate.CoinsTip().Uncache(hashTx);
+        // Uncache coins pertaining to transactions that were not submitted to the mempool.
+        if (test_accept || result.m_state.IsInvalid()) {
+            for (const COutPoint& hashTx : coins_to_uncache) {
+                active_chainstate.CoinsTip().Uncache(hashTx);
+            }
         }
     }
     // Ensure the coins cache is still within limits.
     BlockValidationState state_dummy;
     active_chainstate.FlushStateToDisk(state_dummy, FlushStateMode::PERIODIC);
-    return result;
+    return results;
 }
 
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
@@ -1487,7 +1545,8 @@ CoinsViews::CoinsViews(
     bool in_memory,
     bool should_wipe) : m_dbview(
                             gArgs.GetDataDirNet() / ldb_name, cache_size_bytes, in_memory, should_wipe),
-                        m_catcherview(&m_dbview) {}
+                        m_writerview(m_dbview),
+                        m_catcherview(&m_writerview) {}
 
 void CoinsViews::InitCache()
 {
@@ -1650,6 +1709,15 @@ bool CScriptCheck::operator()() {
     return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata), &error);
 }
 
+bool CScriptCheck::operator()(Batch& batch) {
+    // Deferred signatures are not added to the signature cache, so only
+    // batch them when the results are not cached anyway.
+    if (cacheStore) return (*this)();
+    const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
+    const CScriptWitness *witness = &ptxTo->vin[nIn].scriptWitness;
+    return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata, &batch), &error);
+}
+
 static CuckooCache::cache<uint256, SignatureCacheHasher> g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
 
@@ -1825,7 +1893,6 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
 {
     AssertLockHeld(::cs_main);
-    bool fClean = true;
 
     CBlockUndo blockUndo;
     if (!UndoReadFromDisk(blockUndo, pindex)) {
@@ -1833,6 +1900,14 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
         return DISCONNECT_FAILED;
     }
 
+    return DisconnectBlock(block, std::move(blockUndo), pindex, view);
+}
+
+DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, CBlockUndo&& blockUndo, const CBlockIndex* pindex, CCoinsViewCache& view)
+{
+    AssertLockHeld(::cs_main);
+    bool fClean = true;
+
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
         error("DisconnectBlock(): block and undo data inconsistent");
         return DISCONNECT_FAILED;
@@ -1905,6 +1980,42 @@ void StopScriptCheckWorkerThreads()
     scriptcheckqueue.StopWorkerThreads();
 }
 
+static ThreadPool coinsprefetchpool{"prefetch"};
+
+void StartCoinsPrefetchWorkerThreads(int threads_num)
+{
+    coinsprefetchpool.Start(threads_num, SyscallSandboxPolicy::VALIDATION_PREFETCH);
+}
+
+void StopCoinsPrefetchWorkerThreads()
+{
+    coinsprefetchpool.Stop();
+}
+
+static ThreadPool txprecheckpool{"txcheck"};
+
+void StartTxPreCheckWorkerThreads(int threads_num)
+{
+    txprecheckpool.Start(threads_num, SyscallSandboxPolicy::VALIDATION_SCRIPT_CHECK);
+}
+
+void StopTxPreCheckWorkerThreads()
+{
+    txprecheckpool.Stop();
+}
+
+static ThreadPool blockreadaheadpool{"blockread"};
+
+void StartBlockReadAheadThread()
+{
+    blockreadaheadpool.Start(1, SyscallSandboxPolicy::VALIDATION_BLOCK_READ_AHEAD);
+}
+
+void StopBlockReadAheadThread()
+{
+    blockreadaheadpool.Stop();
+}
+
 /**
  * Threshold condition checker that triggers when unknown versionbits are seen on the network.
  */
@@ -2339,7 +2450,8 @@ CoinsCacheSizeState Chainstate::GetCoinsCacheSizeState(
 {
     AssertLockHeld(::cs_main);
     const int64_t nMempoolUsage = m_mempool ? m_mempool->DynamicMemoryUsage() : 0;
-    int64_t cacheSize = CoinsTip().DynamicMemoryUsage();
+    // Coins that are still being written to disk in the background count as well.
+    int64_t cacheSize = CoinsTip().DynamicMemoryUsage() + CoinsWriter().PendingMemoryUsage();
     int64_t nTotalSpace =
         max_coins_cache_size_bytes + std::max<int64_t>(int64_t(max_mempool_size_bytes) - nMempoolUsage, 0);
 
@@ -2367,7 +2479,6 @@ bool Chainstate::FlushStateToDisk(
     static std::chrono::microseconds nLastWrite{0};
     static std::chrono::microseconds nLastFlush{0};
     std::set<int> setFilesToPrune;
-    bool full_flush_completed = false;
 
     const size_t coins_count = CoinsTip().GetCacheSize();
     const size_t coins_mem_usage = CoinsTip().DynamicMemoryUsage();
@@ -2378,6 +2489,15 @@ bool Chainstate::FlushStateToDisk(
         bool fDoFullFlush = false;
 
         CoinsCacheSizeState cache_state = GetCoinsCacheSizeState();
+        if (cache_state >= CoinsCacheSizeState::CRITICAL && CoinsWriter().IsWriting()) {
+            // Part of the cache space is used by coins still being written to
+            // disk. Wait for them, instead of flushing again right away.
+            LOG_TIME_MILLIS_WITH_CATEGORY("wait for coins to be written to disk", BCLog::BENCH);
+            if (!CoinsWriter().Sync()) {
+                return AbortNode(state, "Failed to write to coin database");
+            }
+            cache_state = GetCoinsCacheSizeState();
+        }
         LOCK(m_blockman.cs_LastBlockFile);
         if (fPruneMode && (m_blockman.m_check_for_pruning || nManualPruneHeight > 0) && !fReindex) {
             // make sure we don't prune above any of the prune locks bestblocks
@@ -2480,8 +2600,13 @@ bool Chainstate::FlushStateToDisk(
             // Flush the chainstate (which may refer to block index entries).
             if (!CoinsTip().Flush())
                 return AbortNode(state, "Failed to write to coin database");
+            // The coins are written to disk in the background, unless callers
+            // rely on them being on disk when this returns.
+            if ((mode == FlushStateMode::ALWAYS || fFlushForPrune) && !CoinsWriter().Sync()) {
+                return AbortNode(state, "Failed to write to coin database");
+            }
             nLastFlush = nNow;
-            full_flush_completed = true;
+            m_flushed_locator = m_chain.GetLocator();
             TRACE5(utxocache, flush,
                    (int64_t)(GetTimeMicros() - nNow.count()), // in microseconds (µs)
                    (uint32_t)mode,
@@ -2490,9 +2615,11 @@ bool Chainstate::FlushStateToDisk(
                    (bool)fFlushForPrune);
         }
     }
-    if (full_flush_completed) {
-        // Update best block in wallet (so we can detect restored wallets).
-        GetMainSignals().ChainStateFlushed(m_chain.GetLocator());
+    if (m_flushed_locator && !CoinsWriter().IsWriting()) {
+        // Update best block in wallet (so we can detect restored wallets),
+        // once the flushed coins are on disk.
+        GetMainSignals().ChainStateFlushed(*m_flushed_locator);
+        m_flushed_locator.reset();
     }
     } catch (const std::runtime_error& e) {
         return AbortNode(state, std::string("System error while flushing: ") + e.what());
@@ -2677,6 +2804,7 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
 }
 
 static SteadyClock::duration time_read_from_disk_total{};
+static SteadyClock::duration time_prefetch_total{};
 static SteadyClock::duration time_connect_total{};
 static SteadyClock::duration time_flush{};
 static SteadyClock::duration time_chainstate{};
@@ -2722,6 +2850,67 @@ public:
     }
 };
 
+void Chainstate::PrefetchBlockInputs(const CBlock& block)
+{
+    AssertLockHeld(cs_main);
+    if (block.vtx.size() <= 1) return;
+
+    // Outputs created within the block itself are never in the coins database.
+    std::unordered_set<uint256, SaltedTxidHasher> block_txids;
+    size_t num_inputs{0};
+    for (const auto& tx : block.vtx) {
+        block_txids.insert(tx->GetHash());
+        num_inputs += tx->vin.size();
+    }
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(num_inputs);
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            if (!block_txids.count(txin.prevout.hash)) outpoints.push_back(txin.prevout);
+        }
+    }
+    const size_t prefetched{CoinsTip().PrefetchCoins(std::move(outpoints), coinsprefetchpool)};
+    LogPrint(BCLog::BENCH, "    - Prefetched %u coins\n", prefetched);
+}
+
+void Chainstate::ReadBlockAhead(const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    if (m_block_read_ahead && m_block_read_ahead->pindex == pindex) return;
+    m_block_read_ahead.reset();
+    // Without a read-ahead thread the block would be read synchronously, for
+    // nothing, as ConnectTip reads it anyway.
+    if (blockreadaheadpool.WorkersCount() == 0) return;
+    if (!(pindex->nStatus & BLOCK_HAVE_DATA)) return;
+
+    const FlatFilePos pos{pindex->GetBlockPos()};
+    const uint256 hash{pindex->GetBlockHash()};
+    const Consensus::Params& consensus_params{m_params.GetConsensus()};
+    auto block{blockreadaheadpool.Submit([pos, hash, &consensus_params]() -> std::shared_ptr<const CBlock> {
+        auto block{std::make_shared<CBlock>()};
+        if (!ReadBlockFromDisk(*block, pos, consensus_params) || block->GetHash() != hash) {
+            return nullptr;
+        }
+        // Compute the merkle root and run the other context-free checks now.
+        // On success this marks the block as checked, so ConnectBlock skips
+        // them. On failure ConnectBlock repeats them to report the error.
+        BlockValidationState state;
+        CheckBlock(*block, state, consensus_params);
+        return block;
+    })};
+    m_block_read_ahead.emplace(BlockReadAhead{pindex, std::move(block)});
+}
+
+std::shared_ptr<const CBlock> Chainstate::TakeBlockReadAhead(const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    if (!m_block_read_ahead || m_block_read_ahead->pindex != pindex) return nullptr;
+    auto future{std::move(m_block_read_ahead->block)};
+    m_block_read_ahead.reset();
+    return future.get();
+}
+
 /**
  * Connect a new block to m_chain. pblock is either nullptr or a pointer to a CBlock
  * corresponding to pindexNew, to bypass loading it again from disk.
@@ -2756,6 +2945,15 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
              Ticks<MillisecondsDouble>(time_2 - time_1),
              Ticks<SecondsDouble>(time_read_from_disk_total),
              Ticks<MillisecondsDouble>(time_read_from_disk_total) / num_blocks_total);
+    // Warm the coins cache with the block's inputs in parallel, so that
+    // ConnectBlock does not have to look them up on disk one at a time.
+    PrefetchBlockInputs(blockConnecting);
+    const auto time_prefetch{SteadyClock::now()};
+    time_prefetch_total += time_prefetch - time_2;
+    LogPrint(BCLog::BENCH, "  - Prefetch inputs: %.2fms [%.2fs (%.2fms/blk)]\n",
+             Ticks<MillisecondsDouble>(time_prefetch - time_2),
+             Ticks<SecondsDouble>(time_prefetch_total),
+             Ticks<MillisecondsDouble>(time_prefetch_total) / num_blocks_total);
     {
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
@@ -2766,10 +2964,10 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
             return error("%s: ConnectBlock %s failed, %s", __func__, pindexNew->GetBlockHash().ToString(), state.ToString());
         }
         time_3 = SteadyClock::now();
-        time_connect_total += time_3 - time_2;
+        time_connect_total += time_3 - time_prefetch;
         assert(num_blocks_total > 0);
         LogPrint(BCLog::BENCH, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n",
-                 Ticks<MillisecondsDouble>(time_3 - time_2),
+                 Ticks<MillisecondsDouble>(time_3 - time_prefetch),
                  Ticks<SecondsDouble>(time_connect_total),
                  Ticks<MillisecondsDouble>(time_connect_total) / num_blocks_total);
         bool flushed = view.Flush();
@@ -2941,7 +3139,13 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
 
         // Connect new blocks.
         for (CBlockIndex* pindexConnect : reverse_iterate(vpindexToConnect)) {
-            if (!ConnectTip(state, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
+            std::shared_ptr<const CBlock> block_connect{pindexConnect == pindexMostWork ? pblock : TakeBlockReadAhead(pindexConnect)};
+            // Read the next block while this one is being connected.
+            if (pindexConnect != pindexMostWork) {
+                CBlockIndex* pindex_next{pindexMostWork->GetAncestor(pindexConnect->nHeight + 1)};
+                if (pindex_next != pindexMostWork || !pblock) ReadBlockAhead(pindex_next);
+            }
+            if (!ConnectTip(state, pindexConnect, block_connect, connectTrace, disconnectpool)) {
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (state.GetResult() != BlockValidationResult::BLOCK_MUTATED) {
@@ -3934,6 +4138,58 @@ MempoolAcceptResult ChainstateManager::ProcessTransaction(const CTransactionRef&
     return result;
 }
 
+/**
+ * The part of ChainstateManager::PreCheckTransaction() that runs on the
+ * worker threads. Scripts are only checked for transactions that pass the
+ * context-free checks, like in AcceptToMemoryPool.
+ */
+static void PreCheckTransactionScripts(const CTxMemPool& pool, const CTransaction& tx, std::vector<CTxOut> spent_outputs)
+{
+    TxValidationState state;
+    if (!CheckTransaction(tx, state)) return;
+    std::string reason;
+    if (pool.m_require_standard && !IsStandardTx(tx, pool.m_max_datacarrier_bytes, pool.m_permit_bare_multisig, pool.m_dust_relay_feerate, reason)) return;
+
+    PrecomputedTransactionData txdata;
+    txdata.Init(tx, std::move(spent_outputs));
+    for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        CScriptCheck check(txdata.m_spent_outputs[i], tx, i, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheIn=*/true, &txdata);
+        if (!check()) return;
+    }
+}
+
+std::optional<std::future<void>> ChainstateManager::PreCheckTransaction(const CTransactionRef& tx, std::function<void()> on_checked)
+{
+    AssertLockHeld(cs_main);
+    Chainstate& active_chainstate = ActiveChainstate();
+    const CTxMemPool* pool{active_chainstate.GetMempool()};
+    if (!pool || tx->IsCoinBase() || txprecheckpool.WorkersCount() == 0) return std::nullopt;
+
+    // Coins that were not cached before are uncached again, as in
+    // AcceptToMemoryPool, so that transactions which end up rejected cannot
+    // be used to fill the coins cache.
+    CCoinsViewCache& coins_tip{active_chainstate.CoinsTip()};
+    std::vector<CTxOut> spent_outputs;
+    spent_outputs.reserve(tx->vin.size());
+    {
+        LOCK(pool->cs);
+        CCoinsViewMemPool view_mempool{&coins_tip, *pool};
+        for (const CTxIn& txin : tx->vin) {
+            const bool cached{coins_tip.HaveCoinInCache(txin.prevout)};
+            Coin coin;
+            const bool found{view_mempool.GetCoin(txin.prevout, coin)};
+            if (!cached) coins_tip.Uncache(txin.prevout);
+            if (!found) return std::nullopt;
+            spent_outputs.push_back(std::move(coin.out));
+        }
+    }
+
+    return txprecheckpool.Submit([pool, tx, spent_outputs = std::move(spent_outputs), on_checked = std::move(on_checked)]() mutable {
+        PreCheckTransactionScripts(*pool, *tx, std::move(spent_outputs));
+        if (on_checked) on_checked();
+    });
+}
+
 bool TestBlockValidity(BlockValidationState& state,
                        const CChainParams& chainparams,
                        Chainstate& chainstate,
@@ -4022,6 +4278,57 @@ CVerifyDB::~CVerifyDB()
     uiInterface.ShowProgress("", 100, false);
 }
 
+namespace {
+/** Outcome of the level 0-2 checks of a single block, computed on a VerifyDB worker thread. */
+struct VerifyDBBlock {
+    CBlock block;
+    //! Undo data read at check level 2, reused when disconnecting the block at level 3
+    std::optional<CBlockUndo> undo;
+    //! Check level that failed, or -1 if all requested checks passed
+    int failed_level{-1};
+    BlockValidationState state;
+    SteadyClock::duration time_read{};
+    SteadyClock::duration time_check{};
+    SteadyClock::duration time_undo{};
+};
+
+VerifyDBBlock VerifyDBCheckBlock(const FlatFilePos& block_pos, const FlatFilePos& undo_pos,
+                                 const uint256& hash, const uint256& prev_hash,
+                                 int check_level, const Consensus::Params& consensus_params)
+{
+    VerifyDBBlock result;
+    const auto time_start{SteadyClock::now()};
+    // check level 0: read from disk
+    if (!ReadBlockFromDisk(result.block, block_pos, consensus_params)) {
+        result.failed_level = 0;
+        return result;
+    }
+    if (result.block.GetHash() != hash) {
+        error("%s: GetHash() doesn't match index for %s at %s", __func__, hash.ToString(), block_pos.ToString());
+        result.failed_level = 0;
+        return result;
+    }
+    const auto time_read{SteadyClock::now()};
+    result.time_read = time_read - time_start;
+    // check level 1: verify block validity
+    if (check_level >= 1 && !CheckBlock(result.block, result.state, consensus_params)) {
+        result.failed_level = 1;
+        return result;
+    }
+    const auto time_check{SteadyClock::now()};
+    result.time_check = time_check - time_read;
+    // check level 2: verify undo validity
+    if (check_level >= 2 && !undo_pos.IsNull()) {
+        if (!UndoReadFromDisk(result.undo.emplace(), undo_pos, prev_hash)) {
+            result.failed_level = 2;
+            return result;
+        }
+        result.time_undo = SteadyClock::now() - time_check;
+    }
+    return result;
+}
+} // namespace
+
 bool CVerifyDB::VerifyDB(
     Chainstate& chainstate,
     const Consensus::Params& consensus_params,
@@ -4030,6 +4337,28 @@ bool CVerifyDB::VerifyDB(
 {
     AssertLockHeld(cs_main);
 
+    ThreadPool pool{"verifydb"};
+    pool.Start(std::clamp(GetNumCores(), 1, MAX_VERIFYDB_THREADS), SyscallSandboxPolicy::VALIDATION_VERIFY_DB);
+    bool ret;
+    try {
+        ret = VerifyBlocks(chainstate, consensus_params, coinsview, nCheckLevel, nCheckDepth, pool);
+    } catch (...) {
+        pool.Stop();
+        throw;
+    }
+    pool.Stop();
+    return ret;
+}
+
+bool CVerifyDB::VerifyBlocks(
+    Chainstate& chainstate,
+    const Consensus::Params& consensus_params,
+    CCoinsView& coinsview,
+    int nCheckLevel, int nCheckDepth,
+    ThreadPool& pool)
+{
+    AssertLockHeld(cs_main);
+
     if (chainstate.m_chain.Tip() == nullptr || chainstate.m_chain.Tip()->pprev == nullptr) {
         return true;
     }
@@ -4044,20 +4373,13 @@ bool CVerifyDB::VerifyDB(
     CBlockIndex* pindex;
     CBlockIndex* pindexFailure = nullptr;
     int nGoodTransactions = 0;
-    BlockValidationState state;
     int reportDone = 0;
-    LogPrintf("[0%%]..."); /* Continued */
 
     const bool is_snapshot_cs{!chainstate.m_from_snapshot_blockhash};
 
+    // Collect the blocks to verify, tip first, so their reads can be queued ahead of time.
+    std::vector<CBlockIndex*> blocks;
     for (pindex = chainstate.m_chain.Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
-        const int percentageDone = std::max(1, std::min(99, (int)(((double)(chainstate.m_chain.Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100))));
-        if (reportDone < percentageDone / 10) {
-            // report every 10% step
-            LogPrintf("[%d%%]...", percentageDone); /* Continued */
-            reportDone = percentageDone / 10;
-        }
-        uiInterface.ShowProgress(_("Verifying blocks…").translated, percentageDone, false);
         if (pindex->nHeight <= chainstate.m_chain.Height() - nCheckDepth) {
             break;
         }
@@ -4067,39 +4389,75 @@ bool CVerifyDB::VerifyDB(
             LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
             break;
         }
-        CBlock block;
-        // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
-            return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+        blocks.push_back(pindex);
+    }
+    LogPrintf("[0%%]..."); /* Continued */
+
+    // Keep only a few blocks per worker in flight, so memory use does not grow with -checkblocks.
+    const size_t max_in_flight{2 * static_cast<size_t>(std::max(1, pool.WorkersCount()))};
+    std::deque<std::future<VerifyDBBlock>> in_flight;
+    size_t next_submit{0};
+    const auto read_ahead{[&](const std::vector<CBlockIndex*>& to_read, int check_level) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+        while (next_submit < to_read.size() && in_flight.size() < max_in_flight) {
+            const CBlockIndex* block_index{to_read[next_submit++]};
+            in_flight.push_back(pool.Submit([block_pos = block_index->GetBlockPos(), undo_pos = block_index->GetUndoPos(),
+                                             hash = block_index->GetBlockHash(), prev_hash = block_index->pprev->GetBlockHash(),
+                                             check_level, &consensus_params] {
+                return VerifyDBCheckBlock(block_pos, undo_pos, hash, prev_hash, check_level, consensus_params);
+            }));
+        }
+        VerifyDBBlock result{in_flight.front().get()};
+        in_flight.pop_front();
+        return result;
+    }};
+
+    SteadyClock::duration time_read{};
+    SteadyClock::duration time_check{};
+    SteadyClock::duration time_undo{};
+    SteadyClock::duration time_disconnect{};
+    SteadyClock::duration time_connect{};
+    const auto time_start{SteadyClock::now()};
+
+    for (CBlockIndex* block_index : blocks) {
+        const int percentageDone = std::max(1, std::min(99, (int)(((double)(chainstate.m_chain.Height() - block_index->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100))));
+        if (reportDone < percentageDone / 10) {
+            // report every 10% step
+            LogPrintf("[%d%%]...", percentageDone); /* Continued */
+            reportDone = percentageDone / 10;
         }
-        // check level 1: verify block validity
-        if (nCheckLevel >= 1 && !CheckBlock(block, state, consensus_params)) {
+        uiInterface.ShowProgress(_("Verifying blocks…").translated, percentageDone, false);
+        // check levels 0-2 were run by the worker threads
+        VerifyDBBlock result{read_ahead(blocks, nCheckLevel)};
+        time_read += result.time_read;
+        time_check += result.time_check;
+        time_undo += result.time_undo;
+        if (result.failed_level == 0) {
+            return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", block_index->nHeight, block_index->GetBlockHash().ToString());
+        }
+        if (result.failed_level == 1) {
             return error("%s: *** found bad block at %d, hash=%s (%s)\n", __func__,
-                         pindex->nHeight, pindex->GetBlockHash().ToString(), state.ToString());
-        }
-        // check level 2: verify undo validity
-        if (nCheckLevel >= 2 && pindex) {
-            CBlockUndo undo;
-            if (!pindex->GetUndoPos().IsNull()) {
-                if (!UndoReadFromDisk(undo, pindex)) {
-                    return error("VerifyDB(): *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-                }
-            }
+                         block_index->nHeight, block_index->GetBlockHash().ToString(), result.state.ToString());
+        }
+        if (result.failed_level == 2) {
+            return error("VerifyDB(): *** found bad undo data at %d, hash=%s\n", block_index->nHeight, block_index->GetBlockHash().ToString());
         }
         // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
         size_t curr_coins_usage = coins.DynamicMemoryUsage() + chainstate.CoinsTip().DynamicMemoryUsage();
 
         if (nCheckLevel >= 3 && curr_coins_usage <= chainstate.m_coinstip_cache_size_bytes) {
-            assert(coins.GetBestBlock() == pindex->GetBlockHash());
-            DisconnectResult res = chainstate.DisconnectBlock(block, pindex, coins);
+            assert(coins.GetBestBlock() == block_index->GetBlockHash());
+            const auto time_disconnect_start{SteadyClock::now()};
+            DisconnectResult res = result.undo ? chainstate.DisconnectBlock(result.block, std::move(*result.undo), block_index, coins) :
+                                                 chainstate.DisconnectBlock(result.block, block_index, coins);
+            time_disconnect += SteadyClock::now() - time_disconnect_start;
             if (res == DISCONNECT_FAILED) {
-                return error("VerifyDB(): *** irrecoverable inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
+                return error("VerifyDB(): *** irrecoverable inconsistency in block data at %d, hash=%s", block_index->nHeight, block_index->GetBlockHash().ToString());
             }
             if (res == DISCONNECT_UNCLEAN) {
                 nGoodTransactions = 0;
-                pindexFailure = pindex;
+                pindexFailure = block_index;
             } else {
-                nGoodTransactions += block.vtx.size();
+                nGoodTransactions += result.block.vtx.size();
             }
         }
         if (ShutdownRequested()) return true;
@@ -4113,27 +4471,39 @@ bool CVerifyDB::VerifyDB(
 
     // check level 4: try reconnecting blocks
     if (nCheckLevel >= 4) {
-        while (pindex != chainstate.m_chain.Tip()) {
-            const int percentageDone = std::max(1, std::min(99, 100 - (int)(((double)(chainstate.m_chain.Height() - pindex->nHeight)) / (double)nCheckDepth * 50)));
+        // Blocks are read and checked ahead on the workers, leaving only
+        // ConnectBlock (and its script check queue) to this thread.
+        std::reverse(blocks.begin(), blocks.end());
+        next_submit = 0;
+        for (CBlockIndex* block_index : blocks) {
+            const int percentageDone = std::max(1, std::min(99, 100 - (int)(((double)(chainstate.m_chain.Height() - block_index->nHeight + 1)) / (double)nCheckDepth * 50)));
             if (reportDone < percentageDone / 10) {
                 // report every 10% step
                 LogPrintf("[%d%%]...", percentageDone); /* Continued */
                 reportDone = percentageDone / 10;
             }
             uiInterface.ShowProgress(_("Verifying blocks…").translated, percentageDone, false);
-            pindex = chainstate.m_chain.Next(pindex);
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus_params))
-                return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-            if (!chainstate.ConnectBlock(block, state, pindex, coins)) {
-                return error("VerifyDB(): *** found unconnectable block at %d, hash=%s (%s)", pindex->nHeight, pindex->GetBlockHash().ToString(), state.ToString());
+            VerifyDBBlock result{read_ahead(blocks, /*check_level=*/1)};
+            time_read += result.time_read;
+            time_check += result.time_check;
+            if (result.failed_level == 0) {
+                return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", block_index->nHeight, block_index->GetBlockHash().ToString());
+            }
+            const auto time_connect_start{SteadyClock::now()};
+            if (result.failed_level == 1 || !chainstate.ConnectBlock(result.block, result.state, block_index, coins)) {
+                return error("VerifyDB(): *** found unconnectable block at %d, hash=%s (%s)", block_index->nHeight, block_index->GetBlockHash().ToString(), result.state.ToString());
             }
+            time_connect += SteadyClock::now() - time_connect_start;
             if (ShutdownRequested()) return true;
         }
     }
 
     LogPrintf("[DONE].\n");
     LogPrintf("No coin database inconsistencies in last %i blocks (%i transactions)\n", block_count, nGoodTransactions);
+    LogPrintf("VerifyDB(): verified %u blocks in %.2fs using %d threads (read %.2fs, check %.2fs, undo %.2fs, disconnect %.2fs, reconnect %.2fs)\n",
+              blocks.size(), Ticks<SecondsDouble>(SteadyClock::now() - time_start), pool.WorkersCount(),
+              Ticks<SecondsDouble>(time_read), Ticks<SecondsDouble>(time_check), Ticks<SecondsDouble>(time_undo),
+              Ticks<SecondsDouble>(time_disconnect), Ticks<SecondsDouble>(time_connect));
 
     return true;
 }
@@ -5028,48 +5398,80 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     const AssumeutxoData& au_data = *maybe_au_data;
 
-    COutPoint outpoint;
-    Coin coin;
     const uint64_t coins_count = metadata.m_coins_count;
-    uint64_t coins_left = metadata.m_coins_count;
 
     LogPrintf("[snapshot] loading coins from snapshot %s\n", base_blockhash.ToString());
-    int64_t coins_processed{0};
-
-    while (coins_left > 0) {
-        try {
-            coins_file >> outpoint;
-            coins_file >> coin;
-        } catch (const std::ios_base::failure&) {
-            LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
-        }
-        if (coin.nHeight > base_height ||
-            outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
-        ) {
-            LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
-        }
-
-        coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
+    uint64_t coins_processed{0};
+
+    // The HASH_SERIALIZED hash of the UTXO set is computed from the chunks as
+    // they are loaded. Chunks hold strictly increasing outpoints, so the coins
+    // end up in the database in the same order and without duplicates, and
+    // the hash is the same as the one computed from the database.
+    HashWriter hash_writer{};
+    hash_writer << base_blockhash;
+
+    // Chunks are read in order, and then checked and deserialized by the
+    // worker threads, while the coins of earlier chunks are being loaded.
+    const int threads_num{std::clamp(GetNumCores(), 1, node::MAX_SNAPSHOT_THREADS)};
+    ThreadPool pool{"snapshot"};
+    pool.Start(threads_num, SyscallSandboxPolicy::VALIDATION_SNAPSHOT);
+
+    const auto load_coins{[&]() -> bool {
+        std::deque<std::future<std::optional<node::SnapshotChunkCoins>>> pending_chunks;
+        uint64_t coins_read{0};
+        std::optional<uint256> prev_txid;
+
+        while (coins_processed < coins_count) {
+            while (coins_read < coins_count && pending_chunks.size() < size_t(2 * threads_num)) {
+                node::SnapshotChunkHeader header;
+                std::vector<unsigned char> data;
+                try {
+                    coins_file >> header;
+                    if (header.m_coins_count == 0 || header.m_coins_count > coins_count - coins_read ||
+                        header.m_size > node::MAX_SNAPSHOT_CHUNK_SIZE) {
+                        LogPrintf("[snapshot] bad snapshot chunk header after deserializing %d coins\n", coins_read);
+                        return false;
+                    }
+                    data.resize(header.m_size);
+                    coins_file.read(MakeWritableByteSpan(data));
+                } catch (const std::ios_base::failure&) {
+                    LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
+                              coins_read);
+                    return false;
+                }
+                coins_read += header.m_coins_count;
+                pending_chunks.push_back(pool.Submit([header, data = std::move(data), base_height] {
+                    return node::ParseSnapshotChunk(header, data, base_height);
+                }));
+            }
 
-        --coins_left;
-        ++coins_processed;
+            std::optional<node::SnapshotChunkCoins> chunk{pending_chunks.front().get()};
+            pending_chunks.pop_front();
+            // Chunks hold whole transactions, and are sorted like their coins.
+            if (!chunk || (prev_txid && !(*prev_txid < chunk->txs.front().first))) {
+                LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
+                          coins_processed);
+                return false;
+            }
+            prev_txid = chunk->txs.back().first;
+            hash_writer.write(MakeByteSpan(chunk->hash_data));
+
+            const uint64_t coins_processed_before{coins_processed};
+            for (auto& [txid, outputs] : chunk->txs) {
+                for (auto& [n, coin] : outputs) {
+                    coins_cache.EmplaceCoinInternalDANGER(COutPoint{txid, n}, std::move(coin));
+                    ++coins_processed;
+                }
+            }
 
-        if (coins_processed % 1000000 == 0) {
-            LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
-                coins_processed,
-                static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
-                coins_cache.DynamicMemoryUsage() / (1000 * 1000));
-        }
+            if (coins_processed / 1000000 != coins_processed_before / 1000000) {
+                LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
+                    coins_processed,
+                    static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
+                    coins_cache.DynamicMemoryUsage() / (1000 * 1000));
+            }
 
-        // Batch write and flush (if we need to) every so often.
-        //
-        // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
-        // means <5MB of memory imprecision.
-        if (coins_processed % 120000 == 0) {
+            // Batch write and flush (if we need to) after every chunk.
             if (ShutdownRequested()) {
                 return false;
             }
@@ -5087,6 +5489,19 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
                 FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
             }
         }
+        return true;
+    }};
+
+    bool coins_loaded;
+    try {
+        coins_loaded = load_coins();
+    } catch (...) {
+        pool.Stop();
+        throw;
+    }
+    pool.Stop();
+    if (!coins_loaded) {
+        return false;
     }
 
     // Important that we set this. This and the coins_cache accesses above are
@@ -5098,7 +5513,8 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     bool out_of_coins{false};
     try {
-        coins_file >> outpoint;
+        node::SnapshotChunkHeader header;
+        coins_file >> header;
     } catch (const std::ios_base::failure&) {
         // We expect an exception since we should be out of coins.
         out_of_coins = true;
@@ -5119,22 +5535,11 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     assert(coins_cache.GetBestBlock() == base_blockhash);
 
-    auto breakpoint_fnc = [] { /* TODO insert breakpoint here? */ };
-
-    // As above, okay to immediately release cs_main here since no other context knows
-    // about the snapshot_chainstate.
-    CCoinsViewDB* snapshot_coinsdb = WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
-
-    const std::optional<CCoinsStats> maybe_stats = ComputeUTXOStats(CoinStatsHashType::HASH_SERIALIZED, snapshot_coinsdb, m_blockman, breakpoint_fnc);
-    if (!maybe_stats.has_value()) {
-        LogPrintf("[snapshot] failed to generate coins stats\n");
-        return false;
-    }
-
     // Assert that the deserialized chainstate contents match the expected assumeutxo value.
-    if (AssumeutxoHash{maybe_stats->hashSerialized} != au_data.hash_serialized) {
+    const uint256 hash_serialized{hash_writer.GetHash()};
+    if (AssumeutxoHash{hash_serialized} != au_data.hash_serialized) {
         LogPrintf("[snapshot] bad snapshot content hash: expected %s, got %s\n",
-            au_data.hash_serialized.ToString(), maybe_stats->hashSerialized.ToString());
+            au_data.hash_serialized.ToString(), hash_serialized.ToString());
         return false;
     }
 
@@ -33,6 +33,8 @@
 #include <versionbits.h>
 
 #include <atomic>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
 #include <optional>
@@ -47,6 +49,7 @@ class Chainstate;
 class CBlockTreeDB;
 class CTxMemPool;
 class ChainstateManager;
+class ThreadPool;
 struct ChainTxData;
 struct DisconnectedBlockTransactions;
 struct PrecomputedTransactionData;
@@ -63,6 +66,18 @@ struct Params;
 static const int MAX_SCRIPTCHECK_THREADS = 15;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Maximum number of UTXO prefetching threads allowed */
+static const int MAX_PREFETCH_THREADS = 16;
+/** -prefetchthreads default (number of threads reading block inputs from the UTXO database, 0 = disabled) */
+static const int DEFAULT_PREFETCH_THREADS = 4;
+/** Maximum number of transaction pre-check threads allowed */
+static const int MAX_TXPRECHECK_THREADS = 16;
+/** -txprecheckthreads default (number of threads checking the scripts of relayed transactions before mempool acceptance, 0 = disabled) */
+static const int DEFAULT_TXPRECHECK_THREADS = 2;
+/** Default for -blockreadahead */
+static const bool DEFAULT_BLOCK_READ_AHEAD = true;
+/** Maximum number of threads reading and checking blocks in VerifyDB */
+static const int MAX_VERIFYDB_THREADS = 16;
 static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 /** Default for -stopatheight */
@@ -115,6 +130,18 @@ extern const std::vector<std::string> CHECKLEVEL_DOC;
 void StartScriptCheckWorkerThreads(int threads_num);
 /** Stop all of the script checking worker threads */
 void StopScriptCheckWorkerThreads();
+/** Run instances of UTXO prefetching worker threads */
+void StartCoinsPrefetchWorkerThreads(int threads_num);
+/** Stop all of the UTXO prefetching worker threads */
+void StopCoinsPrefetchWorkerThreads();
+/** Run instances of transaction pre-check worker threads */
+void StartTxPreCheckWorkerThreads(int threads_num);
+/** Stop all of the transaction pre-check worker threads */
+void StopTxPreCheckWorkerThreads();
+/** Run the thread reading the next block to connect from disk */
+void StartBlockReadAheadThread();
+/** Stop the block read-ahead thread */
+void StopBlockReadAheadThread();
 
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams);
 
@@ -234,13 +261,24 @@ struct PackageMempoolAcceptResult
  *                                It is also used to determine when the entry expires.
  * @param[in]  bypass_limits      When true, don't enforce mempool fee and capacity limits.
  * @param[in]  test_accept        When true, run validation checks but don't submit to mempool.
+ * @param[in]  skip_script_checks When true, don't check the scripts. Only for transactions whose
+ *                                scripts were already checked against the flags of
+ *                                GetMempoolScriptFlags(), such as the ones loaded from mempool.dat.
  *
  * @returns a MempoolAcceptResult indicating whether the transaction was accepted/rejected with reason.
  */
 MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTransactionRef& tx,
-                                       int64_t accept_time, bool bypass_limits, bool test_accept)
+                                       int64_t accept_time, bool bypass_limits, bool test_accept,
+                                       bool skip_script_checks = false)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Consensus script verification flags that AcceptToMemoryPool() checks
+ * transactions against at the current tip, in addition to the standard
+ * policy flags.
+ */
+unsigned int GetMempoolScriptFlags(const Chainstate& active_chainstate) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 /**
 * Validate (and maybe submit) a package to the mempool. See doc/policy/packages.md for full details
 * on package validation rules.
@@ -253,6 +291,17 @@ PackageMempoolAcceptResult ProcessNewPackage(Chainstate& active_chainstate, CTxM
                                                    const Package& txns, bool test_accept)
                                                    EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+* Validate (and maybe submit) several packages to the mempool, one after the other, as if by
+* calling ProcessNewPackage() for each of them. The packages share a single coins view, so confirmed
+* coins are only fetched from the chainstate once per batch, and a parent that an earlier package
+* already submitted is deduplicated against the mempool.
+* @returns a PackageMempoolAcceptResult for each package, in the same order as packages.
+*/
+std::vector<PackageMempoolAcceptResult> ProcessNewPackages(Chainstate& active_chainstate, CTxMemPool& pool,
+                                                           const std::vector<Package>& packages, bool test_accept)
+                                                           EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 /* Mempool validation helper functions */
 
 /**
@@ -303,7 +352,16 @@ public:
     CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn) :
         m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn) { }
 
+    //! Lets CCheckQueue collect the Schnorr signatures of many checks, see operator()(Batch&).
+    using Batch = SchnorrSignatureBatch;
+
     bool operator()();
+    /**
+     * Verify the script, but add Schnorr signatures missing from the
+     * signature cache to batch instead of verifying them. The check passes
+     * only if it returns true and the batch verifies.
+     */
+    bool operator()(Batch& batch);
 
     void swap(CScriptCheck& check) noexcept
     {
@@ -345,9 +403,24 @@ arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers);
 
 /** RAII wrapper for VerifyDB: Verify consistency of the block and coin databases */
 class CVerifyDB {
+private:
+    bool VerifyBlocks(
+        Chainstate& chainstate,
+        const Consensus::Params& consensus_params,
+        CCoinsView& coinsview,
+        int nCheckLevel,
+        int nCheckDepth,
+        ThreadPool& pool) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 public:
     CVerifyDB();
     ~CVerifyDB();
+    /**
+     * Reading blocks and undo data from disk and the context-free block checks
+     * (levels 0-2) run on a pool of worker threads ahead of the blocks being
+     * disconnected (level 3) and reconnected (level 4) on the calling thread.
+     * Reconnecting uses the script check queue when -par enables it.
+     */
     bool VerifyDB(
         Chainstate& chainstate,
         const Consensus::Params& consensus_params,
@@ -389,6 +462,9 @@ public:
     //! All unspent coins reside in this store.
     CCoinsViewDB m_dbview GUARDED_BY(cs_main);
 
+    //! Writes flushed coins to m_dbview on a background thread.
+    CCoinsViewBackgroundWriter m_writerview GUARDED_BY(cs_main);
+
     //! This view wraps access to the leveldb instance and handles read errors gracefully.
     CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
 
@@ -396,8 +472,8 @@ public:
     //! can fit per the dbcache setting.
     std::unique_ptr<CCoinsViewCache> m_cacheview GUARDED_BY(cs_main);
 
-    //! This constructor initializes CCoinsViewDB and CCoinsViewErrorCatcher instances, but it
-    //! *does not* create a CCoinsViewCache instance by default. This is done separately because the
+    //! This constructor initializes CCoinsViewDB, CCoinsViewBackgroundWriter and CCoinsViewErrorCatcher
+    //! instances, but it *does not* create a CCoinsViewCache instance by default. This is done separately because the
     //! presence of the cache has implications on whether or not we're allowed to flush the cache's
     //! state to disk, which should not be done until the health of the database is verified.
     //!
@@ -467,6 +543,19 @@ protected:
     //! Manages the UTXO set, which is a reflection of the contents of `m_chain`.
     std::unique_ptr<CoinsViews> m_coins_views;
 
+    //! Chain tip of the last coins flush, until the flushed coins have been
+    //! written to disk and ChainStateFlushed has been signalled.
+    std::optional<CBlockLocator> m_flushed_locator GUARDED_BY(::cs_main);
+
+    //! A block being read from disk by the read-ahead thread.
+    struct BlockReadAhead {
+        const CBlockIndex* pindex;
+        //! The block, or nullptr if it could not be read.
+        std::future<std::shared_ptr<const CBlock>> block;
+    };
+    //! The block that is expected to be connected next, if it is being read ahead.
+    std::optional<BlockReadAhead> m_block_read_ahead GUARDED_BY(::cs_main);
+
 public:
     //! Reference to a BlockManager instance which itself is shared across all
     //! Chainstate instances.
@@ -542,13 +631,22 @@ public:
         return *m_coins_views->m_cacheview.get();
     }
 
-    //! @returns A reference to the on-disk UTXO set database.
+    //! @returns A reference to the on-disk UTXO set database, once any
+    //!     background write of flushed coins to it has completed.
     CCoinsViewDB& CoinsDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
     {
         AssertLockHeld(::cs_main);
+        m_coins_views->m_writerview.Sync();
         return m_coins_views->m_dbview;
     }
 
+    //! @returns A reference to the view writing flushed coins to the UTXO set database.
+    CCoinsViewBackgroundWriter& CoinsWriter() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        AssertLockHeld(::cs_main);
+        return m_coins_views->m_writerview;
+    }
+
     //! @returns A pointer to the mempool.
     CTxMemPool* GetMempool()
     {
@@ -658,6 +756,9 @@ public:
     // Block (dis)connection on a given view:
     DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /** Same as above, consuming the block's undo data already read from disk. */
+    DisconnectResult DisconnectBlock(const CBlock& block, CBlockUndo&& blockUndo, const CBlockIndex* pindex, CCoinsViewCache& view)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool ConnectBlock(const CBlock& block, BlockValidationState& state, CBlockIndex* pindex,
                       CCoinsViewCache& view, bool fJustCheck = false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -726,6 +827,12 @@ public:
 private:
     bool ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
     bool ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+    //! Load the coins spent by a block into CoinsTip() using the prefetch worker threads.
+    void PrefetchBlockInputs(const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    //! Start reading, deserializing and checking a block on the read-ahead thread.
+    void ReadBlockAhead(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    //! Wait for and return the block read ahead for pindex, or nullptr if it was not.
+    std::shared_ptr<const CBlock> TakeBlockReadAhead(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     void InvalidBlockFound(CBlockIndex* pindex, const BlockValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     CBlockIndex* FindMostWorkChain() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -1025,6 +1132,25 @@ public:
     [[nodiscard]] MempoolAcceptResult ProcessTransaction(const CTransactionRef& tx, bool test_accept=false)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Run the context-free checks and the script checks of a transaction on
+     * the pre-check worker threads, against the coins it spends in the active
+     * chainstate and the mempool.
+     *
+     * cs_main is only needed to look up those coins. The outcome does not
+     * decide anything: signatures that verify are added to the signature
+     * cache, so that a following ProcessTransaction() call for the same
+     * transaction mostly hits the cache and holds cs_main for less time.
+     *
+     * @param[in]  tx          The transaction to check.
+     * @param[in]  on_checked  If set, called on the worker thread once the check is done.
+     * @returns a future that is ready once the check is done, or nothing if
+     *          there are no pre-check threads or the transaction spends
+     *          unknown coins.
+     */
+    std::optional<std::future<void>> PreCheckTransaction(const CTransactionRef& tx, std::function<void()> on_checked = {})
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     //! Load the block tree and coins database from disk, initializing state if we're running with -reindex
     bool LoadBlockIndex() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the -blockindexsnapshot option.
+
+The block index snapshot is written on clean shutdown and used on the next
+startup only, since the block index changes once the node runs.
+"""
+
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+LOADED_MSG = "block index entries from snapshot"
+
+
+class BlockIndexSnapshotTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [["-blockindexsnapshot"]]
+
+    def run_test(self):
+        node = self.nodes[0]
+        snapshot_path = os.path.join(node.datadir, self.chain, "blocks", "blockindex.dat")
+        self.generate(node, 10)
+        tips = node.getchaintips()
+
+        self.log.info("Write the snapshot on shutdown and load it on startup")
+        with node.assert_debug_log(expected_msgs=["block index entries to snapshot"]):
+            self.stop_node(0)
+        assert os.path.isfile(snapshot_path)
+        with node.assert_debug_log(expected_msgs=[LOADED_MSG]):
+            self.start_node(0, extra_args=["-blockindexsnapshot=0"])
+        assert_equal(node.getchaintips(), tips)
+
+        self.log.info("Use the snapshot at most once")
+        self.generate(node, 5)
+        tips = node.getchaintips()
+        with node.assert_debug_log(expected_msgs=[], unexpected_msgs=[LOADED_MSG]):
+            self.restart_node(0, extra_args=["-blockindexsnapshot=0"])
+        assert os.path.isfile(snapshot_path)
+        assert_equal(node.getchaintips(), tips)
+
+
+if __name__ == '__main__':
+    BlockIndexSnapshotTest().main()
@@ -71,9 +71,14 @@ class ChainstateWriteCrashTest(BitcoinTestFramework):
         self.start_nodes()
         # Leave them unconnected, we'll use submitblock directly in this test
 
-    def restart_node(self, node_index, expected_tip):
+    def restart_node(self, node_index, expected_tip, blocks=()):
         """Start up a given node id, wait for the tip to reach the given block hash, and calculate the utxo hash.
 
+        The given blocks are submitted again after startup. Coins are written
+        to disk in the background, so the node may have crashed after
+        accepting blocks that were not yet flushed, or before receiving the
+        last one.
+
         Exceptions on startup should indicate node crash (due to -dbcrashratio), in which case we try again. Give up
         after 60 seconds. Returns the utxo hash of the given node."""
 
@@ -82,6 +87,8 @@ class ChainstateWriteCrashTest(BitcoinTestFramework):
             try:
                 # Any of these RPC calls could throw due to node crash
                 self.start_node(node_index)
+                for block in blocks:
+                    self.nodes[node_index].submitblock(block)
                 self.nodes[node_index].waitforblock(expected_tip)
                 utxo_hash = self.nodes[node_index].gettxoutsetinfo()['hash_serialized_2']
                 return utxo_hash
@@ -139,7 +146,7 @@ class ChainstateWriteCrashTest(BitcoinTestFramework):
         for i in range(3):
             nodei_utxo_hash = None
             self.log.debug(f"Syncing blocks to node {i}")
-            for (block_hash, block) in blocks:
+            for n, (block_hash, block) in enumerate(blocks):
                 # Get the block from node3, and submit to node_i
                 self.log.debug(f"submitting block {block_hash}")
                 if not self.submit_block_catch_error(i, block):
@@ -147,7 +154,7 @@ class ChainstateWriteCrashTest(BitcoinTestFramework):
                     # (change the exit code perhaps, and check that here?)
                     self.wait_for_node_exit(i, timeout=30)
                     self.log.debug(f"Restarting node {i} after block hash {block_hash}")
-                    nodei_utxo_hash = self.restart_node(i, block_hash)
+                    nodei_utxo_hash = self.restart_node(i, block_hash, [b for _, b in blocks[:n + 1]])
                     assert nodei_utxo_hash is not None
                     self.restart_counts[i] += 1
                 else:
@@ -17,6 +17,7 @@ import urllib.parse
 from test_framework.messages import (
     BLOCK_HEADER_SIZE,
     COIN,
+    CTransaction,
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
@@ -348,6 +349,24 @@ class RESTTest (BitcoinTestFramework):
             assert_equal(json_obj[tx]['spentby'], txs[i + 1:i + 2])
             assert_equal(json_obj[tx]['depends'], txs[i - 1:i])
 
+        self.log.info("Test the binary /mempool/contents URI")
+        resp = self.test_rest_request("/mempool/contents", req_type=ReqType.BIN, ret_type=RetType.OBJ)
+        assert_equal(resp.getheader('Transfer-Encoding'), 'chunked')
+        contents = BytesIO(resp.read())
+        entries = []
+        while contents.tell() < len(contents.getvalue()):
+            tx = CTransaction()
+            tx.deserialize(contents)
+            tx.rehash()
+            entries.append((tx.hash, *unpack("<qqq", contents.read(24))))
+        # Parents come before their children
+        assert_equal([entry[0] for entry in entries], txs)
+        for txid, time, fee, modified_fee in entries:
+            assert_equal(time, raw_mempool_verbose[txid]['time'])
+            assert_equal(Decimal(fee) / COIN, raw_mempool_verbose[txid]['fees']['base'])
+            assert_equal(modified_fee, fee)
+        self.test_rest_request("/mempool/info", req_type=ReqType.BIN, status=404, ret_type=RetType.OBJ)
+
         # Now mine the transactions
         newblockhash = self.generate(self.nodes[1], 1)
 
@@ -157,9 +157,10 @@ class MempoolPersistTest(BitcoinTestFramework):
         assert self.nodes[0].getmempoolinfo()["loaded"]
         assert_equal(len(self.nodes[0].getrawmempool()), 0)
 
-        self.log.debug("Stop-start node0. Verify that it has the transactions in its mempool.")
+        self.log.debug("Stop-start node0. Verify that it has the transactions in its mempool, without checking their scripts again.")
         self.stop_nodes()
-        self.start_node(0)
+        with self.nodes[0].assert_debug_log(["Imported mempool transactions from disk: 7 succeeded (7 without script checks)"]):
+            self.start_node(0)
         assert self.nodes[0].getmempoolinfo()["loaded"]
         assert_equal(len(self.nodes[0].getrawmempool()), 7)
 
@@ -169,10 +170,16 @@ class MempoolPersistTest(BitcoinTestFramework):
         assert os.path.isfile(mempooldat0)
         assert_equal(result0['filename'], mempooldat0)
 
-        self.log.debug("Stop nodes, make node1 use mempool.dat from node0. Verify it has 7 transactions")
+        self.log.debug("Stop nodes, make node1 use mempool.dat from node0 with a damaged checksum. Verify it has 7 transactions, with their scripts checked again")
         os.rename(mempooldat0, mempooldat1)
+        with open(mempooldat1, 'r+b') as f:
+            f.seek(-1, os.SEEK_END)
+            last_byte = f.read(1)[0]
+            f.seek(-1, os.SEEK_END)
+            f.write(bytes([last_byte ^ 0xff]))
         self.stop_nodes()
-        self.start_node(1, extra_args=["-persistmempool"])
+        with self.nodes[1].assert_debug_log(["Mempool file checksum mismatch", "7 succeeded (0 without script checks)"]):
+            self.start_node(1, extra_args=["-persistmempool"])
         assert self.nodes[1].getmempoolinfo()["loaded"]
         assert_equal(len(self.nodes[1].getrawmempool()), 7)
 
@@ -87,6 +87,7 @@ class RPCPackagesTest(BitcoinTestFramework):
         self.test_conflicting()
         self.test_rbf()
         self.test_submitpackage()
+        self.test_submitpackages()
 
     def test_independent(self):
         self.log.info("Test multiple independent transactions in a package")
@@ -430,6 +431,41 @@ class RPCPackagesTest(BitcoinTestFramework):
         chain_hex, _ = create_raw_chain(node, self.coins.pop(), self.address, self.privkeys, 3)
         assert_raises_rpc_error(-25, "not-child-with-parents", node.submitpackage, chain_hex)
 
+    def test_submitpackages(self):
+        node = self.nodes[0]
+
+        self.log.info("Submitpackages validates a batch of packages in order")
+        chain_a, txns_a = create_raw_chain(node, self.coins.pop(), self.address, self.privkeys, 2)
+        chain_b, txns_b = create_raw_chain(node, self.coins.pop(), self.address, self.privkeys, 2)
+        chain_invalid, txns_invalid = create_raw_chain(node, self.coins.pop(), self.address, self.privkeys, 3)
+        results = node.submitpackages([chain_a, chain_invalid, chain_b, chain_a])
+        assert_equal(len(results), 4)
+        assert_equal([res["package-msg"] for res in results], ["success", "package-not-child-with-parents", "success", "success"])
+        # A package-wide error has no transaction results
+        assert_equal(results[1]["tx-results"], {})
+        mempool = node.getrawmempool()
+        for tx in txns_a + txns_b:
+            assert tx.rehash() in mempool
+            assert tx.getwtxid() in results[0]["tx-results"] or tx.getwtxid() in results[2]["tx-results"]
+        for tx in txns_invalid:
+            assert tx.rehash() not in mempool
+        # The second submission of chain_a was deduplicated against the first one
+        assert_equal(results[3], results[0])
+
+        self.log.info("Submitpackages reports the transaction that failed a package")
+        chain_c, txns_c = create_raw_chain(node, self.coins.pop(), self.address, self.privkeys, 2)
+        bad_child = tx_from_hex(chain_c[1])
+        bad_child.wit.vtxinwit = []
+        bad_child.vin[0].scriptSig = CScript([OP_TRUE])
+        results = node.submitpackages([[chain_c[0], bad_child.serialize().hex()]])
+        assert_equal(results[0]["package-msg"], "transaction failed")
+        assert "error" in results[0]["tx-results"][bad_child.getwtxid()]
+        assert txns_c[0].rehash() in node.getrawmempool()
+        assert bad_child.rehash() not in node.getrawmempool()
+
+        assert_raises_rpc_error(-8, "Array must contain between 1 and 1000 packages.", node.submitpackages, [])
+        self.generate(node, 1)
+
 
 if __name__ == "__main__":
     RPCPackagesTest().main()
@@ -330,6 +330,7 @@ BASE_SCRIPTS = [
     'p2p_node_network_limited.py',
     'p2p_permissions.py',
     'feature_blocksdir.py',
+    'feature_blockindex_snapshot.py',
     'wallet_startup.py',
     'p2p_i2p_ports.py',
     'p2p_i2p_sessions.py',